@@ -0,0 +1,507 @@
+/*
+  ==============================================================================
+
+    Microbenchmarks for the compressor hot paths, CSV on stdout.
+
+    CompressorBenchmark [--seconds=<audio seconds per case>] [--repeats=<n>]
+                        [--channels=1,2,8] [--blocks=16,...,8192] [--filter=<text>]
+                        [--streams=<streams of the bank suite>]
+
+    Columns: suite, case, channels, block, parameters, ns_per_sample, realtime
+    ns_per_sample is per channel sample, realtime is audio time / processing
+    time for all channels. Best of the repeats is reported. The bank suite
+    counts the audio of all streams, realtime of Threads=n over Threads=1
+    is the scaling with cores.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/CompressorBank.h"
+
+//==============================================================================
+struct BenchmarkSettings
+{
+	double sampleRate = 48000.0;
+	double seconds = 2.0;
+	int repeats = 3;
+	juce::Array<int> channels{ 1, 2, 8 };
+	juce::Array<int> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+	juce::String filter;
+	int streams = 64;
+};
+
+// Noise bursts over a slow sine, exercises attack and release
+static void fillTestSignal(juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+	juce::Random random(1234);
+
+	for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+	{
+		float* data = buffer.getWritePointer(channel);
+
+		for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+		{
+			const float burst = ((int)(sample / (0.1 * sampleRate)) % 2 == 0) ? 0.8f : 0.05f;
+			data[sample] = burst * (random.nextFloat() * 2.0f - 1.0f) + 0.1f * std::sin(0.01f * sample);
+		}
+	}
+}
+
+static double ticksToSeconds(juce::int64 ticks)
+{
+	return juce::Time::highResolutionTicksToSeconds(ticks);
+}
+
+static void report(const juce::String& suite, const juce::String& name, int channels, int blockSize, const juce::String& parameters, double seconds, double audioSeconds, juce::int64 samples)
+{
+	std::cout << suite << "," << name << "," << channels << "," << blockSize << "," << parameters << ","
+		<< juce::String(seconds * 1.0e9 / (double)samples, 3) << "," << juce::String(audioSeconds / seconds, 1) << std::endl;
+}
+
+//==============================================================================
+// Full processBlock, either through the A-D buttons or a forced architecture and ballistic type.
+// SampleType double runs the processor in double precision, silence feeds digital silence
+template<typename SampleType = float, typename Function>
+static void benchmarkProcessor(const BenchmarkSettings& settings, const juce::String& suite, const juce::String& name, Function process, const juce::StringPairArray& parameters, bool silence = false)
+{
+	for (auto channels : settings.channels)
+	{
+		const int totalSamples = (int)(settings.seconds * settings.sampleRate);
+
+		juce::AudioBuffer<float> source(channels, totalSamples);
+		fillTestSignal(source, settings.sampleRate);
+
+		if (silence)
+			source.clear();
+
+		for (auto blockSize : settings.blockSizes)
+		{
+			for (const bool automated : { false, true })
+			{
+				CompressorAudioProcessor processor;
+
+				const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(channels);
+				juce::AudioProcessor::BusesLayout layout;
+				layout.inputBuses.add(channelSet);
+				layout.inputBuses.add(juce::AudioChannelSet::disabled());
+				layout.outputBuses.add(channelSet);
+
+				if (! processor.setBusesLayout(layout))
+					break;
+
+				for (auto& key : parameters.getAllKeys())
+				{
+					auto* parameter = processor.apvts.getParameter(key);
+					parameter->setValueNotifyingHost(parameter->convertTo0to1(parameters[key].getFloatValue()));
+				}
+
+				auto* threshold = processor.apvts.getParameter("Threshold");
+				auto* attack = processor.apvts.getParameter("Attack");
+
+				processor.setNonRealtime(true);
+
+				if (std::is_same<SampleType, double>::value)
+					processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+				processor.prepareToPlay(settings.sampleRate, blockSize);
+
+				juce::AudioBuffer<SampleType> buffer(channels, totalSamples);
+				double best = 1.0e9;
+
+				// First pass warms up caches and state
+				for (int repeat = 0; repeat <= settings.repeats; ++repeat)
+				{
+					buffer.makeCopyOf(source, true);
+
+					const juce::int64 start = juce::Time::getHighResolutionTicks();
+
+					for (int position = 0; position + blockSize <= totalSamples; position += blockSize)
+					{
+						// Host style automation, new values every block
+						if (automated)
+						{
+							const float phase = (float)(position / blockSize % 64) / 64.0f;
+							threshold->setValueNotifyingHost(phase);
+							attack->setValueNotifyingHost(1.0f - phase);
+						}
+
+						juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), channels, position, blockSize);
+						process(processor, block);
+					}
+
+					const double seconds = ticksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+					if (repeat > 0)
+						best = juce::jmin(best, seconds);
+				}
+
+				const juce::int64 processed = (juce::int64)(totalSamples / blockSize) * blockSize;
+				report(suite, name, channels, blockSize, automated ? "automated" : "static", best, processed / settings.sampleRate, processed * channels);
+			}
+		}
+	}
+}
+
+//==============================================================================
+// Single components, one sample at a time
+template<typename Function>
+static void benchmarkComponent(const BenchmarkSettings& settings, const juce::String& name, Function function)
+{
+	const int totalSamples = (int)(settings.seconds * settings.sampleRate);
+
+	juce::AudioBuffer<float> source(1, totalSamples);
+	fillTestSignal(source, settings.sampleRate);
+
+	const float* data = source.getReadPointer(0);
+	double best = 1.0e9;
+	float sink = 0.0f;
+
+	for (int repeat = 0; repeat <= settings.repeats; ++repeat)
+	{
+		const juce::int64 start = juce::Time::getHighResolutionTicks();
+
+		for (int sample = 0; sample < totalSamples; ++sample)
+			sink += function(data[sample]);
+
+		const double seconds = ticksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+		if (repeat > 0)
+			best = juce::jmin(best, seconds);
+	}
+
+	// Keeps the loop from being optimized away
+	if (sink == 12345.0f)
+		std::cerr << sink;
+
+	report("component", name, 1, 1, "static", best, totalSamples / settings.sampleRate, totalSamples);
+}
+
+//==============================================================================
+// Independent streams on a CompressorBank, every stream with its own threshold and signal offset
+static void benchmarkBank(const BenchmarkSettings& settings, const juce::String& name, int threads)
+{
+	const int streams = settings.streams;
+
+	for (auto channels : settings.channels)
+	{
+		const int totalSamples = (int)(settings.seconds * settings.sampleRate);
+
+		juce::AudioBuffer<float> source(channels, totalSamples);
+		fillTestSignal(source, settings.sampleRate);
+
+		for (auto blockSize : settings.blockSizes)
+		{
+			CompressorBank bank(threads);
+			bank.prepare(streams, settings.sampleRate, blockSize, channels);
+
+			for (int stream = 0; stream < streams; ++stream)
+			{
+				CompressorEngine::Parameters parameters;
+				parameters.threshold = -30.0f + (float)(stream % 24);
+				bank.setParameters(stream, parameters);
+			}
+
+			juce::AudioBuffer<float> blocks(streams * channels, blockSize);
+			std::vector<float* const*> buffers;
+
+			for (int stream = 0; stream < streams; ++stream)
+				buffers.push_back(blocks.getArrayOfWritePointers() + stream * channels);
+
+			double best = 1.0e9;
+
+			// First pass warms up caches and state, only the bank is timed, not the copies
+			for (int repeat = 0; repeat <= settings.repeats; ++repeat)
+			{
+				juce::int64 ticks = 0;
+
+				for (int position = 0; position + blockSize <= totalSamples; position += blockSize)
+				{
+					for (int stream = 0; stream < streams; ++stream)
+					{
+						const int offset = (position + stream * 977) % (totalSamples - blockSize + 1);
+
+						for (int channel = 0; channel < channels; ++channel)
+							blocks.copyFrom(stream * channels + channel, 0, source, channel, offset, blockSize);
+					}
+
+					const juce::int64 start = juce::Time::getHighResolutionTicks();
+					bank.process(buffers.data(), blockSize);
+					ticks += juce::Time::getHighResolutionTicks() - start;
+				}
+
+				if (repeat > 0)
+					best = juce::jmin(best, ticksToSeconds(ticks));
+			}
+
+			const juce::int64 processed = (juce::int64)(totalSamples / blockSize) * blockSize;
+			report("bank", name, channels, blockSize, "static", best, processed * streams / settings.sampleRate, processed * channels * streams);
+		}
+	}
+}
+
+static juce::Array<int> parseList(const juce::String& text)
+{
+	juce::StringArray tokens;
+	tokens.addTokens(text, ",", "");
+
+	juce::Array<int> values;
+	for (auto& token : tokens)
+		if (token.getIntValue() > 0)
+			values.add(token.getIntValue());
+
+	return values;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::ScopedNoDenormals noDenormals;
+
+	BenchmarkSettings settings;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const juce::String argument(argv[i]);
+		const juce::String key = argument.upToFirstOccurrenceOf("=", false, false);
+		const juce::String value = argument.fromFirstOccurrenceOf("=", false, false);
+
+		if (key == "--seconds")
+			settings.seconds = juce::jmax(0.01, value.getDoubleValue());
+		else if (key == "--repeats")
+			settings.repeats = juce::jmax(1, value.getIntValue());
+		else if (key == "--channels")
+			settings.channels = parseList(value);
+		else if (key == "--blocks")
+			settings.blockSizes = parseList(value);
+		else if (key == "--filter")
+			settings.filter = value;
+		else if (key == "--streams")
+			settings.streams = juce::jmax(1, value.getIntValue());
+		else
+		{
+			std::cerr << "Usage: CompressorBenchmark [--seconds=2] [--repeats=3] [--channels=1,2,8] [--blocks=16,...,8192] [--filter=text] [--streams=64]" << std::endl;
+			return 1;
+		}
+	}
+
+	auto enabled = [&settings](const juce::String& name) { return settings.filter.isEmpty() || name.contains(settings.filter); };
+
+	std::cout << "suite,case,channels,block,parameters,ns_per_sample,realtime" << std::endl;
+
+	// Components
+	const char* ballisticNames[] = { "Decoupled", "Branching", "SmoothDecoupled", "SmoothBranching" };
+
+	for (int type = EnvelopeFollower::Decoupled; type <= EnvelopeFollower::SmoothBranching; ++type)
+	{
+		const juce::String name = juce::String("EnvelopeFollower::") + ballisticNames[type - 1];
+
+		if (! enabled(name))
+			continue;
+
+		EnvelopeFollower envelopeFollower;
+		envelopeFollower.init((int)settings.sampleRate);
+		envelopeFollower.setCoef(10.0f, 100.0f);
+		envelopeFollower.setBallisticType((EnvelopeFollower::ballisticType)type);
+
+		benchmarkComponent(settings, name, [&envelopeFollower](float in) { return envelopeFollower.process(in); });
+	}
+
+	if (enabled("CrestFactor"))
+	{
+		CrestFactor crestFactor;
+		crestFactor.init((int)settings.sampleRate);
+		crestFactor.setCoef(0.2f);
+
+		benchmarkComponent(settings, "CrestFactor", [&crestFactor](float in) { return crestFactor.process(in); });
+	}
+
+	if (enabled("Decibels"))
+	{
+		benchmarkComponent(settings, "juce::Decibels", [](float in) { return juce::Decibels::decibelsToGain(juce::Decibels::gainToDecibels(in)); });
+		benchmarkComponent(settings, "FastMath::Decibels", [](float in) { return FastMath::decibelsToGain(FastMath::gainToDecibels(in)); });
+	}
+
+	// Modes through the buttons, the path the plugin runs
+	const juce::String modes = "ABCD";
+
+	for (int mode = 0; mode < modes.length(); ++mode)
+	{
+		// Manual and crest factor driven attack / release
+		for (int timing = 0; timing < CompressorAudioProcessor::automationNames.size(); ++timing)
+		{
+			const juce::String name = juce::String("Mode") + modes[mode] + (timing > 0 ? "::" + CompressorAudioProcessor::automationNames[timing] : juce::String());
+
+			if (! enabled(name))
+				continue;
+
+			juce::StringPairArray parameters;
+			for (int button = 0; button < modes.length(); ++button)
+				parameters.set(juce::String("Button") + modes[button], button == mode ? "1" : "0");
+
+			parameters.set("Automation", juce::String(timing));
+
+			juce::MidiBuffer midi;
+			benchmarkProcessor(settings, "mode", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+		}
+	}
+
+	// Every architecture and ballistic type
+	const char* architectureNames[] = { "ReturnToZero", "ReturnToThreshold", "LogDomain" };
+
+	for (int architecture = CompressorEngine::ReturnToZero; architecture <= CompressorEngine::LogDomain; ++architecture)
+	{
+		for (int type = EnvelopeFollower::Decoupled; type <= EnvelopeFollower::SmoothBranching; ++type)
+		{
+			const juce::String name = juce::String(architectureNames[architecture - 1]) + "::" + ballisticNames[type - 1];
+
+			if (! enabled(name))
+				continue;
+
+			benchmarkProcessor(settings, "architecture", name, [architecture, type](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer)
+			{
+				processor.processBlock(buffer, (CompressorAudioProcessor::architecture)architecture, (EnvelopeFollower::ballisticType)type);
+			}, {});
+		}
+	}
+
+	// Mode A at every oversampling factor, cost per host sample
+	for (int stages = 1; stages < CompressorAudioProcessor::oversamplingNames.size(); ++stages)
+	{
+		const juce::String name = "Oversampling::" + CompressorAudioProcessor::oversamplingNames[stages];
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		parameters.set("Oversampling", juce::String(stages));
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "oversampling", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// Mode A with look-ahead, the cost should not grow with the window
+	for (const float lookahead : { 1.0f, 5.0f, 20.0f })
+	{
+		const juce::String name = "Lookahead::" + juce::String((int)lookahead) + "ms";
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		parameters.set("Lookahead", juce::String(lookahead));
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "lookahead", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// RMS and Hybrid detectors, the cost should not grow with the window
+	for (int detection = 1; detection < CompressorAudioProcessor::detectorNames.size(); ++detection)
+	{
+		for (const float window : { 1.0f, 10.0f, 100.0f })
+		{
+			const juce::String name = "Detector::" + CompressorAudioProcessor::detectorNames[detection] + "::" + juce::String((int)window) + "ms";
+
+			if (! enabled(name))
+				continue;
+
+			juce::StringPairArray parameters;
+			parameters.set("Detector", juce::String(detection));
+			parameters.set("RMSWindow", juce::String(window));
+
+			juce::MidiBuffer midi;
+			benchmarkProcessor(settings, "detector", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+		}
+	}
+
+	// Key filters on the channels, the sidechain path without a sidechain bus
+	for (int filter = 1; filter < CompressorAudioProcessor::keyFilterNames.size(); ++filter)
+	{
+		const juce::String name = "KeyFilter::" + CompressorAudioProcessor::keyFilterNames[filter].removeCharacters(" ");
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		parameters.set("KeyFilter", juce::String(filter));
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "sidechain", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// Loudness measurement of input and output plus the makeup gain
+	if (enabled("AutoMakeup"))
+	{
+		juce::StringPairArray parameters;
+		parameters.set("AutoMakeup", "1");
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "loudness", "AutoMakeup", [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// Silent input, the idle fast path
+	for (int mode = 0; mode < modes.length(); ++mode)
+	{
+		const juce::String name = juce::String("Silence::Mode") + modes[mode];
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		for (int button = 0; button < modes.length(); ++button)
+			parameters.set(juce::String("Button") + modes[button], button == mode ? "1" : "0");
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "silence", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters, true);
+	}
+
+	// Modes in double precision, the path of 64-bit hosts
+	for (int mode = 0; mode < modes.length(); ++mode)
+	{
+		const juce::String name = juce::String("Double::Mode") + modes[mode];
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		for (int button = 0; button < modes.length(); ++button)
+			parameters.set(juce::String("Button") + modes[button], button == mode ? "1" : "0");
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor<double>(settings, "precision", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<double>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// Mode A split in 2 to 5 bands, one pass replaces a chain of compressors behind a crossover
+	for (int bands = 2; bands <= CompressorAudioProcessor::MAX_BANDS; ++bands)
+	{
+		const juce::String name = "Bands::" + juce::String(bands);
+
+		if (! enabled(name))
+			continue;
+
+		juce::StringPairArray parameters;
+		parameters.set("Bands", juce::String(bands - 1));
+
+		juce::MidiBuffer midi;
+		benchmarkProcessor(settings, "multiband", name, [&midi](CompressorAudioProcessor& processor, juce::AudioBuffer<float>& buffer) { processor.processBlock(buffer, midi); }, parameters);
+	}
+
+	// Mode A streams of a bank, doubling the threads up to the hardware threads
+	const int hardwareThreads = juce::SystemStats::getNumCpus();
+
+	for (int threads = 1; ; threads = juce::jmin(threads * 2, hardwareThreads))
+	{
+		const juce::String name = "Bank::Threads=" + juce::String(threads);
+
+		if (enabled(name))
+			benchmarkBank(settings, name, threads);
+
+		if (threads >= hardwareThreads)
+			break;
+	}
+
+	return 0;
+}
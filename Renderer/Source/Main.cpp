@@ -0,0 +1,581 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer, runs WAV / FLAC files through the compressor.
+
+    CompressorRenderer [options] files...
+
+    --preset=<file>      key=value lines, same keys as the options below
+    --Attack=<ms>        any parameter of the plugin, by ID
+    --Mode=<A|B|C|D>     compressor type
+    --Link=<mode>        channel link, Off, Max, Mean or Weighted
+    --key=<file>         sidechain of every input, same sample rate, turns Sidechain on
+    --output=<dir>       defaults to the folder of each input
+    --suffix=<text>      appended to output names, defaults to _compressed
+    --threads=<n>        defaults to the number of CPUs
+    --block=<samples>    processing block size, defaults to 1024
+    --meters             writes per block meter values next to each output, CSV
+    --reference=<dir>    compares every output with the file of the same name in dir
+    --tolerance=<dB>     largest difference to the reference, dBFS, defaults to -100
+    --ulp=<n>            differences within n float steps pass as well, defaults to 0
+    --signals=<dir>      writes the canonical test signals to dir and exits
+    --trace=<file>       profiles every block, Chrome / Perfetto JSON trace, one track per file
+
+    A non finite output sample always fails the file. Golden outputs come from
+    rendering the signals once per mode, e.g. --Mode=B --suffix=_B --output=golden
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include <mutex>
+#include <functional>
+#include <limits>
+#include <cstring>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+struct RenderSettings
+{
+	juce::StringPairArray parameters;
+	juce::File outputDirectory;
+	juce::String suffix = "_compressed";
+	int blockSize = 1024;
+	bool meters = false;
+	juce::File referenceDirectory;
+	float toleranceDb = -100.0f;
+	int toleranceUlp = 0;
+	ChromeTrace* trace = nullptr;
+	juce::File keyFile;
+};
+
+static std::mutex logMutex;
+static std::mutex traceMutex;
+
+static void log(const juce::String& message)
+{
+	std::lock_guard<std::mutex> lock(logMutex);
+	std::cout << message << std::endl;
+}
+
+//==============================================================================
+// Adds key=value pairs, Mode expands to the A-D buttons
+static bool addParameter(juce::StringPairArray& parameters, const juce::String& key, const juce::String& value)
+{
+	if (key == "Mode")
+	{
+		const juce::String mode = value.trim().toUpperCase();
+
+		if (mode.length() != 1 || ! juce::String("ABCD").containsChar(mode[0]))
+			return false;
+
+		for (auto button : { "A", "B", "C", "D" })
+			parameters.set(juce::String("Button") + button, mode == button ? "1" : "0");
+
+		return true;
+	}
+
+	parameters.set(key, value.trim());
+	return true;
+}
+
+static bool loadPreset(const juce::File& file, juce::StringPairArray& parameters)
+{
+	if (! file.existsAsFile())
+		return false;
+
+	juce::StringArray lines;
+	file.readLines(lines);
+
+	for (auto& line : lines)
+	{
+		const juce::String text = line.upToFirstOccurrenceOf("#", false, false).trim();
+
+		if (text.isEmpty())
+			continue;
+
+		if (! text.containsChar('=') || ! addParameter(parameters, text.upToFirstOccurrenceOf("=", false, false).trim(), text.fromFirstOccurrenceOf("=", false, false)))
+		{
+			log("Invalid preset line: " + line);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool applyParameters(CompressorAudioProcessor& processor, const juce::StringPairArray& parameters)
+{
+	for (auto& key : parameters.getAllKeys())
+	{
+		auto* parameter = processor.apvts.getParameter(key);
+
+		if (parameter == nullptr)
+		{
+			log("Unknown parameter: " + key);
+			return false;
+		}
+
+		// Choices by name or index, e.g. Link=Max
+		const juce::String value = parameters[key];
+		auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter);
+		const float plainValue = (choice != nullptr && choice->choices.contains(value)) ? (float)choice->choices.indexOf(value) : value.getFloatValue();
+
+		parameter->setValueNotifyingHost(parameter->convertTo0to1(plainValue));
+	}
+
+	return true;
+}
+
+//==============================================================================
+// Canonical signals of the golden outputs, stereo 32 bit float at 48 kHz. Deterministic, fixed seeds
+static bool writeSignals(const juce::File& directory)
+{
+	const double sampleRate = 48000.0;
+	const int samples = (int)(5.0 * sampleRate);
+	const int channels = 2;
+
+	using Generator = std::function<float(int channel, int sample, juce::Random& random)>;
+
+	const std::pair<const char*, Generator> signals[] =
+	{
+		// 1 kHz bursts, 100 ms on and off at three levels
+		{ "sine_bursts", [sampleRate](int, int sample, juce::Random&)
+			{
+				const int burst = (int)(sample / (0.1 * sampleRate));
+				const float level = (burst % 2 == 0) ? 0.0f : (burst % 6 == 1 ? 0.05f : (burst % 6 == 3 ? 0.3f : 0.9f));
+				return level * (float)std::sin(2.0 * juce::MathConstants<double>::pi * 1000.0 * sample / sampleRate);
+			} },
+		{ "noise", [](int, int, juce::Random& random) { return 0.5f * (random.nextFloat() * 2.0f - 1.0f); } },
+
+		// Decaying noise hits every 250 ms, the right channel 5 ms late
+		{ "drums", [sampleRate](int channel, int sample, juce::Random& random)
+			{
+				const int period = (int)(0.25 * sampleRate);
+				const int time = (sample - channel * (int)(0.005 * sampleRate) + period) % period;
+				return 0.95f * (random.nextFloat() * 2.0f - 1.0f) * (float)std::exp(-time / (0.02 * sampleRate));
+			} },
+		{ "silence", [](int, int, juce::Random&) { return 0.0f; } },
+		{ "dc", [](int channel, int, juce::Random&) { return channel == 0 ? 0.5f : -0.25f; } },
+
+		// Alternating values from the smallest denormal up to the smallest normal float
+		{ "denormal", [](int, int sample, juce::Random&)
+			{
+				const float value = std::numeric_limits<float>::denorm_min() * (float)(1 << (sample % 23));
+				return (sample % 2 == 0) ? value : -value;
+			} },
+
+		// Full scale square, loud then a denormal tail the detector has to release into
+		{ "square", [sampleRate](int, int sample, juce::Random&)
+			{
+				const bool loud = sample < (int)(2.5 * sampleRate);
+				const float value = loud ? 1.0f : std::numeric_limits<float>::min() * 0.5f;
+				return ((sample / 24) % 2 == 0) ? value : -value;
+			} },
+	};
+
+	if (! directory.createDirectory())
+		return false;
+
+	juce::WavAudioFormat format;
+	juce::AudioBuffer<float> buffer(channels, samples);
+
+	for (auto& signal : signals)
+	{
+		juce::Random random(2024);
+
+		for (int sample = 0; sample < samples; ++sample)
+			for (int channel = 0; channel < channels; ++channel)
+				buffer.setSample(channel, sample, signal.second(channel, sample, random));
+
+		const juce::File file = directory.getChildFile(juce::String(signal.first) + ".wav");
+		file.deleteFile();
+
+		std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+		std::unique_ptr<juce::AudioFormatWriter> writer(stream != nullptr ? format.createWriterFor(stream.get(), sampleRate, (unsigned int)channels, 32, {}, 0) : nullptr);
+
+		if (writer == nullptr)
+			return false;
+
+		stream.release();
+
+		if (! writer->writeFromAudioSampleBuffer(buffer, 0, samples))
+			return false;
+
+		log(file.getFullPathName());
+	}
+
+	return true;
+}
+
+// Steps between two floats, 0 for equal values, large across signs
+static juce::int64 ulpDistance(float a, float b)
+{
+	auto ordered = [](float value)
+	{
+		juce::int32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return (bits < 0) ? (juce::int64)std::numeric_limits<juce::int32>::min() - bits : (juce::int64)bits;
+	};
+
+	return std::abs(ordered(a) - ordered(b));
+}
+
+// Empty when every sample is within the tolerances, else where and how far it is off
+static juce::String compareFiles(juce::AudioFormatManager& formatManager, const juce::File& output, const juce::File& reference, const RenderSettings& settings)
+{
+	std::unique_ptr<juce::AudioFormatReader> outputReader(formatManager.createReaderFor(output));
+	std::unique_ptr<juce::AudioFormatReader> referenceReader(formatManager.createReaderFor(reference));
+
+	if (outputReader == nullptr || referenceReader == nullptr)
+		return "can not read " + (outputReader == nullptr ? output : reference).getFullPathName();
+
+	if (outputReader->numChannels != referenceReader->numChannels || outputReader->lengthInSamples != referenceReader->lengthInSamples)
+		return "layout or length differs from " + reference.getFullPathName();
+
+	const int channels = (int)outputReader->numChannels;
+	const int blockSize = settings.blockSize;
+	const float tolerance = juce::Decibels::decibelsToGain(settings.toleranceDb);
+
+	juce::AudioBuffer<float> outputBuffer(channels, blockSize);
+	juce::AudioBuffer<float> referenceBuffer(channels, blockSize);
+
+	float maxError = 0.0f;
+	juce::int64 maxUlp = 0;
+	juce::int64 firstFailure = -1;
+
+	for (juce::int64 position = 0; position < outputReader->lengthInSamples; position += blockSize)
+	{
+		const int samples = (int)juce::jmin((juce::int64)blockSize, outputReader->lengthInSamples - position);
+
+		outputReader->read(&outputBuffer, 0, samples, position, true, true);
+		referenceReader->read(&referenceBuffer, 0, samples, position, true, true);
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			const float* out = outputBuffer.getReadPointer(channel);
+			const float* ref = referenceBuffer.getReadPointer(channel);
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				const float error = std::abs(out[sample] - ref[sample]);
+				const juce::int64 ulp = ulpDistance(out[sample], ref[sample]);
+
+				maxError = juce::jmax(maxError, error);
+				maxUlp = juce::jmax(maxUlp, ulp);
+
+				if (firstFailure < 0 && error > tolerance && ulp > settings.toleranceUlp)
+					firstFailure = position + sample;
+			}
+		}
+	}
+
+	if (firstFailure < 0)
+		return {};
+
+	return "differs from " + reference.getFileName() + " at " + juce::String(firstFailure / outputReader->sampleRate, 4) + " s, max error "
+		+ juce::String(juce::Decibels::gainToDecibels(maxError, -200.0f), 1) + " dBFS, " + juce::String(maxUlp) + " ulp";
+}
+
+static bool isFinite(const juce::AudioBuffer<float>& buffer, int samples)
+{
+	for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+	{
+		const float* data = buffer.getReadPointer(channel);
+
+		for (int sample = 0; sample < samples; ++sample)
+			if (! std::isfinite(data[sample]))
+				return false;
+	}
+
+	return true;
+}
+
+//==============================================================================
+// Renders one file, streaming block by block
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+	RenderJob(const juce::File& input, const RenderSettings& settings, int track)
+		: juce::ThreadPoolJob(input.getFileName()), m_input(input), m_settings(settings), m_track(track)
+	{
+	}
+
+	bool succeeded() const { return m_succeeded; }
+
+	JobStatus runJob() override
+	{
+		m_succeeded = render();
+		return jobHasFinished;
+	}
+
+private:
+	bool render()
+	{
+		const double startTime = juce::Time::getMillisecondCounterHiRes();
+
+		juce::AudioFormatManager formatManager;
+		formatManager.registerBasicFormats();
+
+		std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(m_input));
+
+		if (reader == nullptr)
+			return fail("can not read file");
+
+		// Sidechain key, read past its end as silence
+		std::unique_ptr<juce::AudioFormatReader> keyReader;
+
+		if (m_settings.keyFile != juce::File())
+		{
+			keyReader.reset(formatManager.createReaderFor(m_settings.keyFile));
+
+			if (keyReader == nullptr)
+				return fail("can not read " + m_settings.keyFile.getFileName());
+
+			if (keyReader->sampleRate != reader->sampleRate)
+				return fail("key sample rate differs");
+		}
+
+		const int channels = (int)reader->numChannels;
+		const int keyChannels = (keyReader != nullptr) ? (int)keyReader->numChannels : 0;
+		const int blockSize = m_settings.blockSize;
+
+		CompressorAudioProcessor processor;
+
+		const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(channels);
+		juce::AudioProcessor::BusesLayout layout;
+		layout.inputBuses.add(channelSet);
+		layout.inputBuses.add((keyChannels > 0) ? juce::AudioChannelSet::canonicalChannelSet(keyChannels) : juce::AudioChannelSet::disabled());
+		layout.outputBuses.add(channelSet);
+
+		if (! processor.setBusesLayout(layout))
+			return fail(juce::String(channels) + " channels not supported");
+
+		if (! applyParameters(processor, m_settings.parameters))
+			return fail("invalid parameters");
+
+		processor.setNonRealtime(true);
+		processor.prepareToPlay(reader->sampleRate, blockSize);
+		processor.setProfiling(m_settings.trace != nullptr);
+
+		// Output next to the input unless a folder is given
+		const juce::File directory = (m_settings.outputDirectory == juce::File()) ? m_input.getParentDirectory() : m_settings.outputDirectory;
+		const juce::File output = directory.getChildFile(m_input.getFileNameWithoutExtension() + m_settings.suffix + m_input.getFileExtension());
+
+		auto* format = formatManager.findFormatForFileExtension(m_input.getFileExtension());
+		output.deleteFile();
+		std::unique_ptr<juce::FileOutputStream> stream(output.createOutputStream());
+
+		if (format == nullptr || stream == nullptr)
+			return fail("can not create " + output.getFullPathName());
+
+		// FLAC tops out at 24 bit
+		const int bitsPerSample = juce::jmin((int)reader->bitsPerSample, format->getPossibleBitDepths().getLast());
+
+		std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate, (unsigned int)channels, bitsPerSample, reader->metadataValues, 0));
+
+		if (writer == nullptr)
+			return fail("can not create writer");
+
+		// Writer owns the stream now
+		stream.release();
+
+		// The job is the only reader of the meter queue
+		std::unique_ptr<juce::FileOutputStream> meters;
+
+		if (m_settings.meters)
+		{
+			const juce::File metersFile = output.withFileExtension("csv");
+			metersFile.deleteFile();
+			meters = metersFile.createOutputStream();
+
+			if (meters == nullptr)
+				return fail("can not create " + metersFile.getFullPathName());
+
+			*meters << "time,gain_reduction_peak,gain_reduction_average,input_peak,output_peak,attack,release,crest_factor,makeup,short_term_loudness\n";
+		}
+
+		// Main channels first, then the sidechain, the layout of a host buffer
+		juce::AudioBuffer<float> buffer(channels + keyChannels, blockSize);
+		juce::MidiBuffer midi;
+
+		for (juce::int64 position = 0; position < reader->lengthInSamples; position += blockSize)
+		{
+			if (shouldExit())
+				return fail("cancelled");
+
+			const int samples = (int)juce::jmin((juce::int64)blockSize, reader->lengthInSamples - position);
+
+			buffer.setSize(channels + keyChannels, samples, false, false, true);
+			juce::AudioBuffer<float> main(buffer.getArrayOfWritePointers(), channels, samples);
+			reader->read(&main, 0, samples, position, true, true);
+
+			if (keyReader != nullptr)
+			{
+				juce::AudioBuffer<float> key(buffer.getArrayOfWritePointers() + channels, keyChannels, samples);
+				keyReader->read(&key, 0, samples, position, true, true);
+			}
+
+			processor.processBlock(buffer, midi);
+
+			if (! isFinite(main, samples))
+				return fail("non finite output at " + juce::String(position / reader->sampleRate, 4) + " s");
+
+			MeterFrame frame;
+			while (meters != nullptr && processor.popMeterFrame(frame))
+			{
+				*meters << juce::String(position / reader->sampleRate, 4) << "," << juce::String(frame.gainReductionPeakdB, 2) << "," << juce::String(frame.gainReductionAveragedB, 2) << ","
+					<< juce::String(frame.inputPeakdB, 2) << "," << juce::String(frame.outputPeakdB, 2) << ","
+					<< juce::String(frame.attackTime, 1) << "," << juce::String(frame.releaseTime, 1) << "," << juce::String(frame.crestFactorPercentage, 1) << ","
+					<< juce::String(frame.makeupdB, 2) << "," << juce::String(frame.shortTermLoudness, 2) << "\n";
+			}
+
+			if (! writer->writeFromAudioSampleBuffer(main, 0, samples))
+				return fail("write failed");
+
+			ProfileFrame profile;
+			while (m_settings.trace != nullptr && processor.popProfileFrame(profile))
+			{
+				std::lock_guard<std::mutex> lock(traceMutex);
+				m_settings.trace->write(profile, m_track, m_input.getFileName().toRawUTF8());
+			}
+		}
+
+		writer.reset();
+		processor.releaseResources();
+
+		if (m_settings.referenceDirectory != juce::File())
+		{
+			const juce::String difference = compareFiles(formatManager, output, m_settings.referenceDirectory.getChildFile(output.getFileName()), m_settings);
+
+			if (difference.isNotEmpty())
+				return fail(difference);
+		}
+
+		const double seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+		const double duration = reader->lengthInSamples / reader->sampleRate;
+
+		log(m_input.getFileName() + " -> " + output.getFileName()
+			+ " : " + juce::String(duration, 2) + " s audio in " + juce::String(seconds, 3)
+			+ " s, realtime factor " + juce::String(duration / juce::jmax(seconds, 1e-9), 1));
+
+		if (m_settings.trace != nullptr)
+		{
+			const auto& stats = processor.getProfileStats();
+			log(m_input.getFileName() + " : " + juce::String((int)stats.getBlocks()) + " blocks, max load " + juce::String(stats.getMaxLoad(), 3)
+				+ ", " + juce::String((int)stats.getOverruns()) + " over the block duration");
+		}
+
+		return true;
+	}
+
+	bool fail(const juce::String& message)
+	{
+		log(m_input.getFileName() + " : " + message);
+		return false;
+	}
+
+	const juce::File m_input;
+	const RenderSettings& m_settings;
+	const int m_track;
+	bool m_succeeded = false;
+};
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	RenderSettings settings;
+	int threads = juce::SystemStats::getNumCpus();
+	juce::Array<juce::File> inputs;
+	ChromeTrace trace;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const juce::String argument(argv[i]);
+
+		if (! argument.startsWith("--"))
+		{
+			inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(argument));
+			continue;
+		}
+
+		const juce::String key = argument.substring(2).upToFirstOccurrenceOf("=", false, false);
+		const juce::String value = argument.fromFirstOccurrenceOf("=", false, false);
+
+		bool valid = true;
+
+		if (key == "preset")
+			valid = loadPreset(juce::File::getCurrentWorkingDirectory().getChildFile(value), settings.parameters);
+		else if (key == "output")
+			settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (key == "suffix")
+			settings.suffix = value;
+		else if (key == "threads")
+			threads = value.getIntValue();
+		else if (key == "block")
+			settings.blockSize = value.getIntValue();
+		else if (key == "meters")
+			settings.meters = true;
+		else if (key == "reference")
+			settings.referenceDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (key == "tolerance")
+			settings.toleranceDb = value.getFloatValue();
+		else if (key == "ulp")
+			settings.toleranceUlp = juce::jmax(0, value.getIntValue());
+		else if (key == "trace")
+			valid = trace.open(juce::File::getCurrentWorkingDirectory().getChildFile(value).getFullPathName().toStdString());
+		else if (key == "key")
+			settings.keyFile = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (key == "signals")
+			return writeSignals(juce::File::getCurrentWorkingDirectory().getChildFile(value)) ? 0 : 1;
+		else
+			valid = addParameter(settings.parameters, key, value);
+
+		if (! valid)
+		{
+			log("Invalid argument: " + argument);
+			return 1;
+		}
+	}
+
+	if (inputs.isEmpty() || threads < 1 || settings.blockSize < 1)
+	{
+		log("Usage: CompressorRenderer [--preset=file] [--Mode=A|B|C|D] [--<Parameter>=value] [--output=dir] [--suffix=text] [--threads=n] [--block=samples] [--meters] [--reference=dir] [--tolerance=dB] [--ulp=n] [--trace=file] [--key=file] files...\n"
+			"       CompressorRenderer --signals=dir");
+		return 1;
+	}
+
+	if (settings.outputDirectory != juce::File())
+		settings.outputDirectory.createDirectory();
+
+	if (settings.keyFile != juce::File() && ! settings.parameters.containsKey("Sidechain"))
+		settings.parameters.set("Sidechain", "1");
+
+	if (trace.isOpen())
+		settings.trace = &trace;
+
+	const double startTime = juce::Time::getMillisecondCounterHiRes();
+
+	// Jobs outlive the pool
+	juce::OwnedArray<RenderJob> jobs;
+	juce::ThreadPool pool(threads);
+
+	for (auto& input : inputs)
+		pool.addJob(jobs.add(new RenderJob(input, settings, jobs.size() + 1)), false);
+
+	for (auto* job : jobs)
+		pool.waitForJobToFinish(job, -1);
+
+	int failed = 0;
+	for (auto* job : jobs)
+		if (! job->succeeded())
+			++failed;
+
+	log(juce::String(jobs.size() - failed) + " of " + juce::String(jobs.size()) + " files rendered in "
+		+ juce::String((juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001, 2) + " s on " + juce::String(threads) + " threads");
+
+	return (failed == 0) ? 0 : 1;
+}
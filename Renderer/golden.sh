@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Golden output regression check of the compressor, through the renderer.
+#
+#   Renderer/golden.sh generate <git ref>   renders the reference set with the renderer built at ref
+#   Renderer/golden.sh check                renders with the working tree and compares with the reference set
+#
+# The canonical signals of --signals run through every case below, each case into its own folder. check fails,
+# exit code 1, on a sample off by more than TOLERANCE dBFS (default -100) and ULP float steps (default 0), or on
+# any non finite sample. Tag the build the references come from, e.g. git tag golden && golden.sh generate golden.
+#
+# GOLDEN_DIR       reference set, defaults to Renderer/Golden (not tracked, it is regenerated from the tag)
+# PROJUCER         Projucer executable, resaves the jucer into its Linux Makefile, defaults to Projucer
+# JOBS             make jobs, defaults to the number of CPUs
+#
+# Building needs the JUCE modules at the path of the jucer, ~/JUCE/modules.
+
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+golden=${GOLDEN_DIR:-$root/Renderer/Golden}
+projucer=${PROJUCER:-Projucer}
+jobs=${JOBS:-$(nproc 2>/dev/null || echo 4)}
+
+# Name and renderer options of every case, modes A-D cover both architectures and both ballistic types
+cases="A:--Mode=A
+B:--Mode=B
+C:--Mode=C
+D:--Mode=D
+Linked:--Mode=A --Link=Weighted
+AutoTiming:--Mode=C --Automation=Auto
+Lookahead:--Mode=B --Lookahead=5
+Oversampling:--Mode=D --Oversampling=4x
+Multiband:--Mode=A --Bands=3"
+
+# Builds the renderer of the tree at $1, prints the executable
+build()
+{
+	"$projucer" --resave "$1/Renderer/CompressorRenderer.jucer" >&2
+	make -C "$1/Renderer/Builds/LinuxMakefile" CONFIG=Release -j"$jobs" >&2
+	echo "$1/Renderer/Builds/LinuxMakefile/build/CompressorRenderer"
+}
+
+# Renders the signals through every case into $2/<case>, extra renderer options in $3, {case} is the case name
+render()
+{
+	echo "$cases" | while IFS=: read -r name arguments
+	do
+		# Word splitting of the options is intended
+		# shellcheck disable=SC2086
+		"$1" $arguments --suffix= --output="$2/$name" $(echo "$3" | sed "s#{case}#$name#g") "$golden"/signals/*.wav || exit 1
+	done
+}
+
+case "$1" in
+generate)
+	[ -n "$2" ] || { echo "Usage: $0 generate <git ref>" >&2; exit 1; }
+
+	tree=$(mktemp -d)
+	trap 'git -C "$root" worktree remove --force "$tree"' EXIT
+	git -C "$root" worktree add --detach "$tree" "$2" >&2
+
+	renderer=$(build "$tree")
+
+	rm -rf "$golden"
+	mkdir -p "$golden"
+	"$renderer" --signals="$golden/signals"
+	render "$renderer" "$golden" ""
+
+	git -C "$root" rev-parse "$2" > "$golden/REVISION"
+	echo "Reference set of $2 in $golden"
+	;;
+
+check)
+	[ -f "$golden/REVISION" ] || { echo "No reference set in $golden, run $0 generate <git ref> first" >&2; exit 1; }
+
+	renderer=$(build "$root")
+	output=$(mktemp -d)
+	trap 'rm -rf "$output"' EXIT
+
+	render "$renderer" "$output" "--reference=$golden/{case} --tolerance=${TOLERANCE:--100} --ulp=${ULP:-0}"
+	echo "Matches the reference set of $(cat "$golden/REVISION")"
+	;;
+
+*)
+	echo "Usage: $0 generate <git ref> | check" >&2
+	exit 1
+	;;
+esac
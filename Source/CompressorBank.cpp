@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Many independent compressor streams processed together.
+
+  ==============================================================================
+*/
+
+#include <new>
+#include "CompressorBank.h"
+
+//==============================================================================
+CompressorBank::CompressorBank(int threads)
+	: m_pool(threads)
+{
+}
+
+void CompressorBank::prepare(int streams, double sampleRate, int maxBlockSize, int channels)
+{
+	streams = std::max(0, streams);
+
+	m_streams = 0;
+	m_channels = std::max(1, channels);
+	m_sampleRate = sampleRate;
+	m_blockSize = maxBlockSize;
+
+	m_engines.reset(new CompressorEngine[(size_t)streams]);
+	m_parameters.assign((size_t)streams, CompressorEngine::Parameters());
+	m_changed.assign((size_t)streams, 0);
+
+	// Every engine allocates its own state, in parallel since this dominates start up with many streams.
+	// Pool tasks must not throw, a failed allocation is rethrown here
+	std::atomic<bool> outOfMemory{ false };
+
+	auto prepareStream = [this, sampleRate, maxBlockSize, &outOfMemory](int stream)
+	{
+		try
+		{
+			m_engines[(size_t)stream].prepare(sampleRate, maxBlockSize, m_channels);
+		}
+		catch (const std::bad_alloc&)
+		{
+			outOfMemory = true;
+		}
+	};
+
+	m_pool.run(streams, prepareStream);
+
+	if (outOfMemory)
+		throw std::bad_alloc();
+
+	m_streams = streams;
+}
+
+void CompressorBank::setParameters(int stream, const CompressorEngine::Parameters& parameters)
+{
+	m_parameters[(size_t)stream] = parameters;
+	m_changed[(size_t)stream] = 1;
+}
+
+void CompressorBank::reset(int stream)
+{
+	applyParameters(stream);
+
+	// prepare resets as well
+	auto& engine = m_engines[(size_t)stream];
+	if (engine.needsPrepare())
+		engine.prepare(m_sampleRate, m_blockSize, m_channels);
+	else
+		engine.reset();
+}
+
+void CompressorBank::applyParameters(int stream)
+{
+	if (m_changed[(size_t)stream] == 0)
+		return;
+
+	m_engines[(size_t)stream].setParameters(m_parameters[(size_t)stream]);
+	m_changed[(size_t)stream] = 0;
+}
+
+//==============================================================================
+void CompressorBank::process(float* const* const* buffers, int samples)
+{
+	auto processStream = [this, buffers, samples](int stream)
+	{
+		applyParameters(stream);
+		m_engines[(size_t)stream].process(buffers[stream], m_channels, samples);
+	};
+
+	m_pool.run(m_streams, processStream);
+}
+
+void CompressorBank::processInterleaved(float* const* buffers, int samples)
+{
+	auto processStream = [this, buffers, samples](int stream)
+	{
+		applyParameters(stream);
+		m_engines[(size_t)stream].processInterleaved(buffers[stream], samples);
+	};
+
+	m_pool.run(m_streams, processStream);
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    Many independent compressor streams processed together, one
+    CompressorEngine each, for servers running a compressor per stream.
+
+    The engines sit in one array allocated in prepare, parameters of every
+    stream in a second one. Setting parameters only marks the stream, they
+    are applied by the thread that processes it next. A block of all streams
+    runs on a WorkStealingPool, one stream per task, so a stream never
+    moves between threads within a block and needs no locking.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "CompressorEngine.h"
+#include "WorkStealingPool.h"
+
+//==============================================================================
+class CompressorBank
+{
+public:
+	// threads counts the calling thread, 0 uses the hardware threads
+	explicit CompressorBank(int threads = 0);
+
+	// Allocates streams engines of the same layout and block size, all with default parameters
+	void prepare(int streams, double sampleRate, int maxBlockSize, int channels);
+
+	int getNumStreams() const { return m_streams; }
+	int getNumChannels() const { return m_channels; }
+	int getNumThreads() const { return m_pool.getNumThreads(); }
+
+	// Applied at the next process of the stream. Not concurrent with process
+	void setParameters(int stream, const CompressorEngine::Parameters& parameters);
+	const CompressorEngine::Parameters& getParameters(int stream) const { return m_parameters[(size_t)stream]; }
+
+	// Clears the state of a stream for a new source, keeps its parameters. Allocates when they need longer
+	// RMS windows than the stream was prepared for, see CompressorEngine::needsPrepare
+	void reset(int stream);
+
+	// Direct access for link weights, latency and meters, not while processing
+	CompressorEngine& getEngine(int stream) { return m_engines[(size_t)stream]; }
+
+	// In place, buffers[stream] holds the planar channels of a stream, samples each, any length
+	void process(float* const* const* buffers, int samples);
+
+	// In place, buffers[stream] holds samples interleaved frames of a stream
+	void processInterleaved(float* const* buffers, int samples);
+
+private:
+	int m_streams = 0;
+	int m_channels = 0;
+	double m_sampleRate = 0.0;
+	int m_blockSize = 0;
+
+	std::unique_ptr<CompressorEngine[]> m_engines;
+	std::vector<CompressorEngine::Parameters> m_parameters;
+
+	// One byte per stream, set by setParameters, cleared by the processing thread
+	std::vector<unsigned char> m_changed;
+
+	WorkStealingPool m_pool;
+
+	void applyParameters(int stream);
+};
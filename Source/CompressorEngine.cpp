@@ -0,0 +1,1381 @@
+/*
+  ==============================================================================
+
+    Compressor engine, see CompressorEngine.h.
+
+  ==============================================================================
+*/
+
+#include "CompressorEngine.h"
+
+//==============================================================================
+void TimeCoefficientTable::init(int sampleRate)
+{
+	for (int i = 0; i < SIZE; ++i)
+	{
+		const float timeMs = MIN_TIME_MS * std::exp2((float)i / STEPS_PER_OCTAVE);
+		m_table[i] = exp(-1000.0f / (timeMs * sampleRate));
+	}
+}
+
+//==============================================================================
+void CompressorEngine::getMode(int mode, architecture& architecture, EnvelopeFollower::ballisticType& ballisticType)
+{
+	// A and B compute the gain in the log domain, C and D return to zero. A and C smooth decoupled, B and D branching
+	architecture = (mode < 2) ? architecture::LogDomain : architecture::ReturnToZero;
+	ballisticType = (mode % 2 == 0) ? EnvelopeFollower::ballisticType::SmoothDecoupled : EnvelopeFollower::ballisticType::SmoothBranching;
+}
+
+CompressorEngine::Parameters::Parameters()
+{
+	for (int band = 0; band < MAX_BANDS; ++band)
+		getMode(0, modes.architectures[band], modes.ballisticTypes[band]);
+}
+
+//==============================================================================
+void CompressorEngine::prepare(double sampleRate, int maxBlockSize, int channels, bool doublePrecision, int keyChannels)
+{
+	channels = std::max(1, channels);
+	keyChannels = std::max(0, keyChannels);
+
+	m_sampleRate = sampleRate;
+	m_blockSize = maxBlockSize;
+	m_channels = channels;
+	m_keyChannels = keyChannels;
+
+	// Stage buffers hold a block at the highest factor, so the factor can change without allocation
+	const int stageSamples = maxBlockSize * OversamplerStages::MAX_FACTOR;
+
+	// Only the used precision is allocated, the other one is released
+	if (doublePrecision)
+	{
+		prepareSampleState(m_doubleState, channels, keyChannels, maxBlockSize);
+		m_floatState = SampleState<float>();
+	}
+	else
+	{
+		prepareSampleState(m_floatState, channels, keyChannels, maxBlockSize);
+		m_doubleState = SampleState<double>();
+	}
+
+	// Interleaved blocks are split into planar ones at the base rate
+	m_interleaved.setSize(doublePrecision ? 0 : channels, maxBlockSize);
+	m_interleavedChannels.assign(channels, nullptr);
+
+	for (int channel = 0; channel < m_interleaved.getNumChannels(); ++channel)
+		m_interleavedChannels[channel] = m_interleaved.getWritePointer(channel);
+
+	m_lookaheadSamples = 0;
+
+	// Equal weights until the layout sets its own, a prepare of the same layout keeps them
+	if ((int)m_linkWeights.size() != channels)
+		m_linkWeights.assign(channels, 1.0f / channels);
+
+	// Auto makeup measures and applies at the base rate
+	m_loudness.prepare(channels, sampleRate, maxBlockSize);
+	m_loudness.setWeights(m_linkWeights.data());
+	m_makeupRamp.init((int)sampleRate, MAKEUP_RAMP_MS);
+
+	// Auto timing
+	const int controlPeriods = (stageSamples + CONTROL_PERIOD - 1) / CONTROL_PERIOD;
+	m_autoAttackCoef.setSize(channels, controlPeriods);
+	m_autoReleaseCoef.setSize(channels, controlPeriods);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	// Lanes are float only, double runs the scalar kernels
+	const int laneGroups = doublePrecision ? 0 : (channels + EnvelopeFollowerLanes::LANES - 1) / EnvelopeFollowerLanes::LANES;
+	m_laneGroups = laneGroups;
+	m_laneGroupState.assign(MAX_BANDS * laneGroups, LaneGroupState());
+
+	m_laneSilence.assign(laneGroups > 0 ? stageSamples : 0, 0.0f);
+	m_laneScratch.assign(laneGroups > 0 ? stageSamples : 0, 0.0f);
+#endif
+
+	m_blockPath.assign(channels, FullPath);
+	m_ramps.setSize(RampChannels, stageSamples);
+
+	// RMS rings for the current parameters only, a 100 ms ring at 8x is 38400 samples per band and channel
+	Parameters rmsParameters = m_parameters;
+
+	if (m_maxRmsWindows)
+	{
+		rmsParameters.detection = detector::Rms;
+		rmsParameters.oversampling = OversamplerStages::MAX_STAGES;
+		rmsParameters.bands = MAX_BANDS;
+	}
+
+	m_rmsCapacity = getRmsCapacity(rmsParameters);
+	m_rmsBands = (m_rmsCapacity > 0) ? rmsParameters.bands : 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	const bool lanes = ! doublePrecision && channels > 1;
+#else
+	const bool lanes = false;
+#endif
+
+	if (doublePrecision)
+		allocateRms(m_doubleState, channels, false);
+	else
+		allocateRms(m_floatState, channels, lanes);
+
+	reset();
+}
+
+void CompressorEngine::reset()
+{
+	// Detectors start released, filters and delays silent
+	auto clear = [](auto& state)
+	{
+		for (auto& channelState : state.channelState)
+		{
+			channelState.envelopeFollower = {};
+			channelState.crestFactor = {};
+			channelState.runningRms.reset();
+		}
+
+		state.gainCurve.clear();
+	};
+
+	clear(m_floatState);
+	clear(m_doubleState);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	for (auto& laneGroupState : m_laneGroupState)
+	{
+		laneGroupState.envelopeFollower = {};
+		laneGroupState.runningRms.reset();
+	}
+#endif
+
+	m_gainCurveSamples = 0;
+	m_gainCurveChannels = 0;
+
+	// Start on the current values, no ramp
+	m_thresholdRamp.setCurrentAndTarget(m_parameters.threshold);
+	m_slopeRamp.setCurrentAndTarget((1.0f / m_parameters.ratio) - 1.0f);
+	m_mixRamp.setCurrentAndTarget(m_parameters.mix);
+	m_volumeRamp.setCurrentAndTarget(decibelsToGain(m_parameters.volume));
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+		m_bandThresholdRamps[band].setCurrentAndTarget((m_parameters.bands > 1) ? m_parameters.bandThresholds[band] : 0.0f);
+
+	// Loudness history starts over at 0 dB makeup
+	m_loudness.reset();
+	m_autoMakeup = m_parameters.autoMakeup;
+	m_makeupRamp.setCurrentAndTarget(1.0f);
+
+	// Rates, oversampling filters, crossovers, look-ahead and RMS windows
+	m_detection = m_parameters.detection;
+	updateOversampling(m_parameters.oversampling);
+	updateLookahead(getLookaheadSamples());
+	updateRmsWindow(getRmsWindowSamples());
+}
+
+void CompressorEngine::setParameters(const Parameters& parameters)
+{
+	m_parameters = parameters;
+
+	auto& p = m_parameters;
+	p.attack = std::clamp(p.attack, 0.1f, 80.0f);
+	p.release = std::clamp(p.release, 1.0f, 200.0f);
+	p.ratio = std::clamp(p.ratio, 0.6f, 8.0f);
+	p.threshold = std::clamp(p.threshold, -60.0f, 12.0f);
+	p.mix = std::clamp(p.mix, 0.0f, 1.0f);
+	p.volume = std::clamp(p.volume, -24.0f, 24.0f);
+	p.lookahead = std::clamp(p.lookahead, 0.0f, MAX_LOOKAHEAD_MS);
+	p.link = (channelLink)std::clamp((int)p.link, (int)Unlinked, (int)Weighted);
+	p.timing = (automation)std::clamp((int)p.timing, (int)Manual, (int)Auto);
+	p.detection = (detector)std::clamp((int)p.detection, (int)Peak, (int)Hybrid);
+	p.rmsWindow = std::clamp(p.rmsWindow, MIN_RMS_WINDOW_MS, MAX_RMS_WINDOW_MS);
+	p.keyFilter = (keyFilterType)std::clamp((int)p.keyFilter, (int)Unfiltered, (int)BandPass);
+	p.keyFrequency = std::clamp(p.keyFrequency, 20.0f, 20000.0f);
+	p.oversampling = std::clamp(p.oversampling, 0, OversamplerStages::MAX_STAGES);
+	p.bands = std::clamp(p.bands, 1, MAX_BANDS);
+
+	for (auto& crossover : p.crossovers)
+		crossover = std::clamp(crossover, 20.0f, 20000.0f);
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+	{
+		p.bandThresholds[band] = std::clamp(p.bandThresholds[band], -MAX_BAND_THRESHOLD_DB, MAX_BAND_THRESHOLD_DB);
+		p.modes.architectures[band] = (architecture)std::clamp((int)p.modes.architectures[band], (int)ReturnToZero, (int)LogDomain);
+		p.modes.ballisticTypes[band] = (EnvelopeFollower::ballisticType)std::clamp((int)p.modes.ballisticTypes[band], (int)EnvelopeFollower::Decoupled, (int)EnvelopeFollower::SmoothBranching);
+	}
+}
+
+void CompressorEngine::setLinkWeights(const float* weights)
+{
+	std::copy(weights, weights + m_linkWeights.size(), m_linkWeights.begin());
+
+	// Loudness weighs the channels the same way
+	m_loudness.setWeights(m_linkWeights.data());
+}
+
+int CompressorEngine::getLookaheadSamples() const
+{
+	return (int)std::lrint(m_parameters.lookahead * 0.001 * m_sampleRate);
+}
+
+int CompressorEngine::getRmsWindowSamples() const
+{
+	return std::max(1, (int)std::lrint(m_parameters.rmsWindow * 0.001 * m_sampleRate));
+}
+
+int CompressorEngine::getRmsCapacity(const Parameters& parameters) const
+{
+	if (parameters.detection == detector::Peak)
+		return 0;
+
+	return (int)std::ceil(MAX_RMS_WINDOW_MS * 0.001 * m_sampleRate) << std::clamp(parameters.oversampling, 0, OversamplerStages::MAX_STAGES);
+}
+
+bool CompressorEngine::needsPrepare() const
+{
+	return m_parameters.detection != detector::Peak && (getRmsCapacity(m_parameters) > m_rmsCapacity || m_parameters.bands > m_rmsBands);
+}
+
+template<typename SampleType>
+void CompressorEngine::allocateRms(SampleState<SampleType>& state, int channels, bool lanes)
+{
+	// Lanes run unlinked float, the scalar rings of the first channel keep the linked detector
+	for (int band = 0; band < MAX_BANDS; ++band)
+		for (int channel = 0; channel < channels; ++channel)
+			state.channelState[band * channels + channel].runningRms.init((band < m_rmsBands && (! lanes || channel == 0)) ? m_rmsCapacity : 1);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	for (int band = 0; band < MAX_BANDS; ++band)
+		for (int group = 0; group < m_laneGroups; ++group)
+			m_laneGroupState[band * m_laneGroups + group].runningRms.init((band < m_rmsBands && lanes) ? m_rmsCapacity : 1);
+#endif
+}
+
+//==============================================================================
+void CompressorEngine::process(float* const* channels, int numChannels, int samples)
+{
+	processSamples(channels, numChannels, samples);
+}
+
+void CompressorEngine::process(double* const* channels, int numChannels, int samples)
+{
+	processSamples(channels, numChannels, samples);
+}
+
+void CompressorEngine::process(float* const* channels, int numChannels, int samples, const float* const* key, int keyChannels)
+{
+	processSamples(channels, numChannels, samples, key, keyChannels);
+}
+
+void CompressorEngine::process(double* const* channels, int numChannels, int samples, const double* const* key, int keyChannels)
+{
+	processSamples(channels, numChannels, samples, key, keyChannels);
+}
+
+void CompressorEngine::processInterleaved(float* data, int samples)
+{
+	const int channels = m_interleaved.getNumChannels();
+
+	// Prepared for double, or not at all
+	assert(channels > 0);
+	if (channels == 0)
+		return;
+
+	for (int start = 0; start < samples; start += m_blockSize)
+	{
+		const int length = std::min(m_blockSize, samples - start);
+		float* block = data + (size_t)start * channels;
+
+		for (int channel = 0; channel < channels; ++channel)
+			for (int sample = 0; sample < length; ++sample)
+				m_interleavedChannels[channel][sample] = block[sample * channels + channel];
+
+		processSamples(m_interleavedChannels.data(), channels, length);
+
+		for (int channel = 0; channel < channels; ++channel)
+			for (int sample = 0; sample < length; ++sample)
+				block[sample * channels + channel] = m_interleavedChannels[channel][sample];
+	}
+}
+
+template<typename SampleType>
+void CompressorEngine::prepareSampleState(SampleState<SampleType>& state, int channels, int keyChannels, int samplesPerBlock)
+{
+	const int stageSamples = samplesPerBlock * OversamplerStages::MAX_FACTOR;
+
+	state.oversampler.prepare(channels, samplesPerBlock);
+	state.crossover.prepare(channels, stageSamples);
+
+	// The filter runs on the sidechain or on the channels of every band, whichever keys the detectors
+	const int filteredChannels = std::max(channels, keyChannels);
+
+	state.keyOversampler.prepare(keyChannels, samplesPerBlock);
+	state.keyFilters.resize(MAX_BANDS);
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+		state.keyFilters[band].prepare((band == 0) ? filteredChannels : channels, stageSamples);
+	state.keyBuffers.assign(keyChannels, nullptr);
+	state.key.setSize(filteredChannels, stageSamples);
+	state.filteredKeyBuffers.resize(filteredChannels);
+
+	for (int channel = 0; channel < filteredChannels; ++channel)
+		state.filteredKeyBuffers[channel] = state.key.getWritePointer(channel);
+
+	// Fresh state for every band and channel of the current layout, sample rate is set by updateOversampling
+	state.channelState.assign(MAX_BANDS * channels, ChannelState<SampleType>());
+
+	// Look-ahead buffers for the longest window at the highest factor
+	const int maxLookahead = (int)std::ceil(MAX_LOOKAHEAD_MS * 0.001 * m_sampleRate) * OversamplerStages::MAX_FACTOR;
+
+	for (auto& channelState : state.channelState)
+	{
+		channelState.slidingMaximum.init(maxLookahead + 1);
+		channelState.delayLine.init(maxLookahead);
+	}
+
+	state.channelBuffers.assign(channels, nullptr);
+	state.gainCurveBuffers.assign(channels, nullptr);
+
+	state.gainCurve.setSize(channels, stageSamples);
+	state.gainCurve.clear();
+	state.gain.setSize(1, stageSamples);
+
+	// Every band keeps its own buffer for the whole sub-block
+	state.bands.setSize(MAX_BANDS * channels, stageSamples);
+	state.bandBuffers.resize(MAX_BANDS * channels);
+
+	for (int index = 0; index < MAX_BANDS * channels; ++index)
+		state.bandBuffers[index] = state.bands.getWritePointer(index);
+}
+
+void CompressorEngine::updateOversampling(int stages)
+{
+	m_oversamplingStages = std::clamp(stages, 0, OversamplerStages::MAX_STAGES);
+
+	// Detector and auto timing run at the oversampled rate
+	const int sampleRate = (int)(m_sampleRate * (1 << m_oversamplingStages));
+
+	// Only the prepared precision has channels
+	auto update = [&](auto& state)
+	{
+		state.oversampler.setStages(m_oversamplingStages);
+		state.oversampler.reset();
+		state.crossover.reset();
+		state.keyOversampler.setStages(m_oversamplingStages);
+		state.keyOversampler.reset();
+
+		for (auto& keyFilter : state.keyFilters)
+			keyFilter.reset();
+
+		for (auto& channelState : state.channelState)
+		{
+			channelState.envelopeFollower.init(sampleRate);
+			channelState.crestFactor.init(sampleRate);
+			channelState.crestFactor.setCoef(0.2f);
+		}
+	};
+
+	update(m_floatState);
+	update(m_doubleState);
+
+	m_timeCoefficients.init(sampleRate);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	for (auto& laneGroupState : m_laneGroupState)
+		laneGroupState.envelopeFollower.init(sampleRate);
+#endif
+
+	// Manual coefficients and ramp lengths depend on the rate
+	m_cachedAttack = -1.0f;
+	m_cachedRelease = -1.0f;
+
+	m_thresholdRamp.init(sampleRate, PARAMETER_RAMP_MS);
+	m_slopeRamp.init(sampleRate, PARAMETER_RAMP_MS);
+	m_mixRamp.init(sampleRate, PARAMETER_RAMP_MS);
+	m_volumeRamp.init(sampleRate, PARAMETER_RAMP_MS);
+
+	for (auto& bandThresholdRamp : m_bandThresholdRamps)
+		bandThresholdRamp.init(sampleRate, PARAMETER_RAMP_MS);
+
+	// Windows are counted in oversampled samples
+	updateLookahead(m_lookaheadSamples);
+	updateRmsWindow(m_rmsWindowSamples);
+}
+
+void CompressorEngine::updateLookahead(int samples)
+{
+	m_lookaheadSamples = samples;
+
+	const int stageSamples = samples << m_oversamplingStages;
+
+	auto update = [&](auto& state)
+	{
+		for (auto& channelState : state.channelState)
+		{
+			channelState.slidingMaximum.setWindow(stageSamples + 1);
+			channelState.delayLine.setDelay(stageSamples);
+		}
+	};
+
+	update(m_floatState);
+	update(m_doubleState);
+
+	updateLatency();
+}
+
+void CompressorEngine::updateRmsWindow(int samples)
+{
+	m_rmsWindowSamples = samples;
+
+	const int stageSamples = samples << m_oversamplingStages;
+
+	auto update = [&](auto& state)
+	{
+		for (auto& channelState : state.channelState)
+			channelState.runningRms.setWindow(stageSamples);
+	};
+
+	update(m_floatState);
+	update(m_doubleState);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	for (auto& laneGroupState : m_laneGroupState)
+		laneGroupState.runningRms.setWindow(stageSamples);
+#endif
+}
+
+void CompressorEngine::updateLatency()
+{
+	// Dry and wet both pass the filters and the delay, so the whole output is delayed
+	m_latencySamples = (int)std::lrint(OversamplerStages::getLatency(m_oversamplingStages)) + m_lookaheadSamples;
+}
+
+template<typename SampleType>
+void CompressorEngine::processSamples(SampleType* const* data, int numChannels, int samples, const SampleType* const* key, int keyChannels)
+{
+	auto& state = getSampleState<SampleType>();
+
+	// Stage laps go to the profile frame, nothing is timed while profiling is off
+	const bool profiling = m_profiling.load(std::memory_order_acquire);
+	if (profiling)
+		m_profileFrame = ProfileFrame();
+
+	StageTimer timer(m_profileFrame, profiling);
+
+	// Get params
+	const auto& parameters = m_parameters;
+	const auto attack = parameters.attack;
+	const auto release = parameters.release;
+	const auto ratio = parameters.ratio;
+	const auto threshold = parameters.threshold;
+	const auto mix = parameters.mix;
+	const auto volume = decibelsToGain(parameters.volume);
+	const auto link = parameters.link;
+	const auto timing = parameters.timing;
+	const auto detection = parameters.detection;
+	const auto rmsWindow = getRmsWindowSamples();
+	const auto oversampling = parameters.oversampling;
+	const auto lookahead = getLookaheadSamples();
+	const auto bands = parameters.bands;
+	const auto& modes = parameters.modes;
+
+	// Channel state is sized in prepare for the layout, MAX_BANDS per channel. None for the other precision
+	const int channels = std::min(numChannels, (int)state.channelState.size() / MAX_BANDS);
+	assert(channels == m_channels);
+
+	// Scratch buffers hold at most the prepared block size
+	const int blockSize = m_blockSize;
+	assert(blockSize > 0);
+	if (blockSize == 0 || channels == 0)
+		return;
+
+	// Factor changed, re-init the rate dependent state before the coefficients are set
+	if (oversampling != m_oversamplingStages)
+		updateOversampling(oversampling);
+
+	// New length restarts the delay, the host is told the new latency
+	if (lookahead != m_lookaheadSamples)
+		updateLookahead(lookahead);
+
+	// New window restarts the running sums, so does a switch from Peak that left them stale
+	if (rmsWindow != m_rmsWindowSamples || detection != m_detection)
+	{
+		m_detection = detection;
+		updateRmsWindow(rmsWindow);
+	}
+
+	const int factor = 1 << m_oversamplingStages;
+
+	// Crossovers run at the oversampled rate, kept ascending. A new band count restarts the filters
+	float crossovers[MAX_BANDS - 1];
+	for (int split = 0; split < bands - 1; ++split)
+		crossovers[split] = std::max(parameters.crossovers[split], (split > 0) ? crossovers[split - 1] : 0.0f);
+
+	state.crossover.setBands(bands, crossovers, m_sampleRate * factor);
+
+	// Gain related parameters ramp to the new values, nothing happens when they did not change
+	m_thresholdRamp.setTarget(threshold);
+	m_slopeRamp.setTarget((1.0f / ratio) - 1.0f);
+	m_mixRamp.setTarget(mix);
+	m_volumeRamp.setTarget(volume);
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+		m_bandThresholdRamps[band].setTarget((bands > 1) ? parameters.bandThresholds[band] : 0.0f);
+
+	float* thresholdRamp = m_ramps.getWritePointer(ThresholdRamp);
+	float* slopeRamp = m_ramps.getWritePointer(SlopeRamp);
+	float* mixRamp = m_ramps.getWritePointer(MixRamp);
+	float* volumeRamp = m_ramps.getWritePointer(VolumeRamp);
+	float* bandThresholdRamp = m_ramps.getWritePointer(BandThresholdRamp);
+	float* makeupRamp = m_ramps.getWritePointer(MakeupRamp);
+
+	// Switched on, the loudness history starts over. Switched off, the gain glides back to 0 dB
+	const bool autoMakeup = parameters.autoMakeup;
+
+	if (autoMakeup != m_autoMakeup)
+	{
+		m_autoMakeup = autoMakeup;
+
+		if (autoMakeup)
+			m_loudness.reset();
+		else
+			m_makeupRamp.setTarget(1.0f);
+	}
+
+	const bool makeup = autoMakeup || m_makeupRamp.isRamping() || m_makeupRamp.getCurrent() != 1.0f;
+
+	// Manual attack and release, two exp only when a time changed
+	if (attack != m_cachedAttack || release != m_cachedRelease)
+	{
+		const int sampleRate = (int)(m_sampleRate * factor);
+
+		m_attackCoef = EnvelopeFollowerBase::timeToCoefficient((double)attack, sampleRate);
+		m_releaseCoef = EnvelopeFollowerBase::timeToCoefficient((double)release, sampleRate);
+		m_cachedAttack = attack;
+		m_cachedRelease = release;
+	}
+
+	// Meters, timesAutomation overrides the times
+	m_meterFrame = MeterFrame();
+	m_meterFrame.attackTime = attack;
+	m_meterFrame.releaseTime = release;
+	timer.lap(ProfileFrame::Setup);
+	m_meterFrame.inputPeakdB = gainToDecibels(getPeak(data, channels, samples));
+	timer.lap(ProfileFrame::Meters);
+
+	float gainReductionSum = 0.0f;
+
+	// Sidechain channels beyond the prepared ones are ignored
+	const int sidechainChannels = (parameters.sidechain && key != nullptr) ? std::min(keyChannels, m_keyChannels) : 0;
+	const bool keyed = sidechainChannels > 0;
+	const bool keyFiltered = parameters.keyFilter != keyFilterType::Unfiltered;
+	const int levelChannels = keyed ? sidechainChannels : channels;
+
+	// Linked, one detector on the combined level drives every channel. So does a key of another layout,
+	// on its Max or Mean as the weights belong to the channels
+	const bool keyMatches = levelChannels == channels;
+	const bool linked = (link != channelLink::Unlinked && channels > 1) || ! keyMatches;
+	const int detectorChannels = linked ? 1 : channels;
+
+	channelLink levelLink = link;
+	if (! keyMatches)
+		levelLink = (link == channelLink::Mean || link == channelLink::Weighted) ? channelLink::Mean : channelLink::Max;
+
+	// Key filter at the oversampled rate, a new response restarts it. Without a sidechain every band filters its own signal
+	if (keyFiltered)
+		for (int band = 0; band < (keyed ? 1 : bands); ++band)
+			state.keyFilters[band].setFilter(parameters.keyFilter == keyFilterType::BandPass, parameters.keyFrequency, m_sampleRate * factor);
+
+	// Auto timing sets the coefficients once per control period
+	const bool autoTiming = timing == automation::Auto;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	// Multichannel float, run all channels as lanes of one vector
+	const bool useLanes = std::is_same<SampleType, float>::value && detectorChannels > 1;
+
+	if (! autoTiming)
+		for (auto& laneGroupState : m_laneGroupState)
+			laneGroupState.envelopeFollower.setCoefficients(FastMath::Vec4((float)m_attackCoef), FastMath::Vec4((float)m_releaseCoef));
+#else
+	const bool useLanes = false;
+#endif
+
+	for (int band = 0; band < bands; ++band)
+	{
+		for (int channel = 0; channel < detectorChannels; ++channel)
+		{
+			// Envelope reference
+			auto& envelopeFollower = state.channelState[band * channels + channel].envelopeFollower;
+
+			// Set attack and release
+			if (! autoTiming)
+				envelopeFollower.setCoefficients((SampleType)m_attackCoef, (SampleType)m_releaseCoef);
+
+			// Set ballistic type
+			envelopeFollower.setBallisticType(modes.ballisticTypes[band]);
+		}
+	}
+
+	for (int start = 0; start < samples; start += blockSize)
+	{
+		const int hostLength = std::min(blockSize, samples - start);
+
+		SampleType* const* gainCurve = state.gainCurveBuffers.data();
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			state.channelBuffers[channel] = data[channel] + start;
+			state.gainCurveBuffers[channel] = state.gainCurve.getWritePointer(channel);
+		}
+
+		// Input loudness of the sub-block before it is processed in place
+		if (autoMakeup)
+		{
+			m_loudness.measureInput(state.channelBuffers.data(), hostLength);
+			timer.lap(ProfileFrame::Meters);
+		}
+
+		// Every stage below runs on the oversampled signal
+		SampleType* const* channelBuffers = (factor > 1) ? state.oversampler.up(state.channelBuffers.data(), channels, hostLength) : state.channelBuffers.data();
+		const int length = hostLength * factor;
+
+		// Detector key at the oversampled rate, the channels themselves unless a sidechain replaces them.
+		// Every band reads the whole sidechain
+		const SampleType* const* levelSource = nullptr;
+
+		if (keyed)
+		{
+			for (int channel = 0; channel < sidechainChannels; ++channel)
+				state.keyBuffers[channel] = key[channel] + start;
+
+			levelSource = (factor > 1) ? state.keyOversampler.up(state.keyBuffers.data(), sidechainChannels, hostLength) : state.keyBuffers.data();
+		}
+
+		timer.lap(ProfileFrame::Oversampling);
+
+		if (keyed && keyFiltered)
+		{
+			state.keyFilters[0].process(levelSource, state.filteredKeyBuffers.data(), levelChannels, length);
+			levelSource = state.filteredKeyBuffers.data();
+			timer.lap(ProfileFrame::Detector);
+		}
+
+		// Ramps of this sub-block, constants once they settled
+		bool bandRamping = false;
+		for (int band = 0; band < bands; ++band)
+			bandRamping = bandRamping || m_bandThresholdRamps[band].isRamping();
+
+		const bool curveRamping = m_thresholdRamp.isRamping() || m_slopeRamp.isRamping() || bandRamping;
+		const bool gainRamping = m_mixRamp.isRamping() || m_volumeRamp.isRamping();
+
+		if (curveRamping)
+		{
+			m_thresholdRamp.fill(thresholdRamp, length);
+			m_slopeRamp.fill(slopeRamp, length);
+		}
+
+		if (gainRamping)
+		{
+			m_mixRamp.fill(mixRamp, length);
+			m_volumeRamp.fill(volumeRamp, length);
+		}
+
+		// Values at the end of the sub-block, the targets when not ramping
+		const float R_Inv_minus_One = m_slopeRamp.getCurrent();
+		const float volumeGain = m_volumeRamp.getCurrent();
+		const float volumeMix = m_volumeRamp.getCurrent() * m_mixRamp.getCurrent();
+		const float volumeMixInverse = m_volumeRamp.getCurrent() * (1.0f - m_mixRamp.getCurrent());
+		timer.lap(ProfileFrame::Setup);
+
+		// Detector, gain computer and gain stage of one band, in place on its channels
+		auto processBand = [&](int band, SampleType* const* channelBuffers)
+		{
+			const CompressorEngine::architecture architecture = modes.architectures[band];
+			const EnvelopeFollower::ballisticType ballisticType = modes.ballisticTypes[band];
+			ChannelState<SampleType>* channelState = state.channelState.data() + band * channels;
+
+			// Pick specialized detector once per band
+			const Kernel<SampleType> kernel = kernels<SampleType>[architecture - 1][ballisticType - 1];
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+			const KernelLanes kernelLanes = kernelsLanes[architecture - 1][ballisticType - 1];
+			LaneGroupState* laneGroupState = m_laneGroupState.data() + band * m_laneGroups;
+#endif
+
+			// Threshold of the band, the global one plus its offset
+			if (curveRamping)
+			{
+				m_bandThresholdRamps[band].fill(bandThresholdRamp, length);
+				FastMath::transform(thresholdRamp, bandThresholdRamp, bandThresholdRamp, length, [](auto threshold, auto offset) { return threshold + offset; });
+			}
+
+			const float curveThreshold = m_thresholdRamp.getCurrent() + m_bandThresholdRamps[band].getCurrent();
+
+			// Mics constants
+			KernelParams params;
+			params.thresholdGain = decibelsToGain(curveThreshold);
+			params.factor = (R_Inv_minus_One < 0.0f) ? -1.0f : 1.0f;
+
+			auto computeGain = [&](const SampleType* level, SampleType* gaindB)
+			{
+				if (curveRamping)
+					gainComputer(level, gaindB, length, bandThresholdRamp, slopeRamp);
+				else
+					gainComputer(level, gaindB, length, curveThreshold, R_Inv_minus_One);
+			};
+
+			// Band channels, or the sidechain when one is set. Without one the key filter runs on the band
+			const SampleType* const* levelChannelBuffers = (levelSource != nullptr) ? levelSource : channelBuffers;
+
+			if (keyFiltered && ! keyed)
+			{
+				state.keyFilters[band].process(channelBuffers, state.filteredKeyBuffers.data(), channels, length);
+				levelChannelBuffers = state.filteredKeyBuffers.data();
+			}
+
+			// Combined level replaces the channels as detector input
+			if (linked)
+				linkLevels(levelChannelBuffers, gainCurve[0], levelChannels, length, levelLink, m_linkWeights.data());
+
+			const SampleType* const* levelIn = linked ? gainCurve : levelChannelBuffers;
+
+			// Auto timing reads the level before LogDomain replaces it
+			if (autoTiming)
+			{
+				for (int channel = 0; channel < detectorChannels; ++channel)
+				{
+					float* attackCoef = m_autoAttackCoef.getWritePointer(channel);
+					float* releaseCoef = m_autoReleaseCoef.getWritePointer(channel);
+
+					for (int offset = 0, period = 0; offset < length; offset += CONTROL_PERIOD, ++period)
+						timesAutomation(levelIn[channel] + offset, std::min(CONTROL_PERIOD, length - offset), channelState[channel].crestFactor, attack, release, attackCoef[period], releaseCoef[period]);
+				}
+			}
+
+			// RMS and Hybrid read the windowed RMS of the level, look-ahead then holds its peak
+			if (detection != detector::Peak)
+			{
+				const bool hybrid = detection == detector::Hybrid;
+
+				if (useLanes)
+				{
+#if FASTMATH_SSE2 || FASTMATH_NEON
+					if constexpr (std::is_same<SampleType, float>::value)
+					{
+						for (int group = 0; group < m_laneGroups; ++group)
+						{
+							const int first = group * RunningRmsLanes::LANES;
+							const int groupChannels = std::min(RunningRmsLanes::LANES, detectorChannels - first);
+
+							if (groupChannels <= 0)
+								continue;
+
+							// Unused lanes repeat the last channel
+							const float* in[RunningRmsLanes::LANES];
+							float* out[RunningRmsLanes::LANES];
+
+							for (int lane = 0; lane < RunningRmsLanes::LANES; ++lane)
+							{
+								const int channel = first + std::min(lane, groupChannels - 1);
+								in[lane] = levelIn[channel];
+								out[lane] = gainCurve[channel];
+							}
+
+							laneGroupState[group].runningRms.process(in, out, length, hybrid);
+						}
+					}
+#endif
+				}
+				else
+				{
+					for (int channel = 0; channel < detectorChannels; ++channel)
+						channelState[channel].runningRms.process(levelIn[channel], gainCurve[channel], length, hybrid);
+				}
+
+				levelIn = gainCurve;
+			}
+
+			// Look-ahead, the detector sees the peak of the window the delayed audio is about to enter.
+			// Dry and wet are both taken from the delayed channels, so Mix stays aligned
+			if (m_lookaheadSamples > 0)
+			{
+				for (int channel = 0; channel < detectorChannels; ++channel)
+					channelState[channel].slidingMaximum.process(levelIn[channel], gainCurve[channel], length);
+
+				for (int channel = 0; channel < channels; ++channel)
+					channelState[channel].delayLine.process(channelBuffers[channel], length);
+
+				levelIn = gainCurve;
+			}
+
+			// Channels whose gain provably stays at 0 dB skip the gain computer and the dB conversions,
+			// silent ones also the detector. Ramping curves and ReturnToThreshold take the full path
+			const bool fastPath = ! curveRamping && architecture != architecture::ReturnToThreshold;
+
+			for (int channel = 0; channel < detectorChannels; ++channel)
+				m_blockPath[channel] = fastPath ? getBlockPath(architecture, FastMath::peak(levelIn[channel], length), getEnvelopeLevel<SampleType>(band, channel, useLanes), curveThreshold) : FullPath;
+
+			// LogDomain computes the gain curve first and smooths it in place
+			if (architecture == architecture::LogDomain)
+			{
+				for (int channel = 0; channel < detectorChannels; ++channel)
+				{
+					// Idle channels too, a lane group runs them when another channel is active
+					if (m_blockPath[channel] == FullPath)
+						computeGain(levelIn[channel], gainCurve[channel]);
+					else
+						std::fill(gainCurve[channel], gainCurve[channel] + length, SampleType(0));
+				}
+			}
+
+			const SampleType* const* detectorIn = (architecture == architecture::LogDomain) ? gainCurve : levelIn;
+
+			// Detector, the only recursive stage, split into control periods with auto timing
+			const int segmentSize = autoTiming ? CONTROL_PERIOD : length;
+
+			for (int offset = 0, period = 0; offset < length; offset += segmentSize, ++period)
+			{
+				const int segmentLength = std::min(segmentSize, length - offset);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+				if constexpr (std::is_same<SampleType, float>::value)
+				{
+					if (useLanes)
+					{
+						for (int group = 0; group < m_laneGroups; ++group)
+						{
+							const int first = group * EnvelopeFollowerLanes::LANES;
+							const int groupChannels = std::min(EnvelopeFollowerLanes::LANES, detectorChannels - first);
+
+							if (groupChannels <= 0)
+								continue;
+
+							auto& envelopeFollower = laneGroupState[group].envelopeFollower;
+
+							// Unused lanes repeat the last channel
+							const float* in[EnvelopeFollowerLanes::LANES];
+							float* out[EnvelopeFollowerLanes::LANES];
+							const float* attackCoef[EnvelopeFollowerLanes::LANES];
+							const float* releaseCoef[EnvelopeFollowerLanes::LANES];
+
+							for (int lane = 0; lane < EnvelopeFollowerLanes::LANES; ++lane)
+							{
+								const int channel = first + std::min(lane, groupChannels - 1);
+								in[lane] = detectorIn[channel] + offset;
+								out[lane] = gainCurve[channel] + offset;
+								attackCoef[lane] = m_autoAttackCoef.getReadPointer(channel);
+								releaseCoef[lane] = m_autoReleaseCoef.getReadPointer(channel);
+							}
+
+							if (autoTiming)
+								envelopeFollower.setCoefficients(FastMath::Vec4::gather(attackCoef, period), FastMath::Vec4::gather(releaseCoef, period));
+
+							// A group with any active channel runs all its lanes
+							bool groupIdle = true;
+							for (int lane = 0; lane < groupChannels; ++lane)
+								groupIdle = groupIdle && m_blockPath[first + lane] == IdlePath;
+
+							if (groupIdle)
+								envelopeFollower.decay(ballisticType, segmentLength);
+							else
+								(this->*kernelLanes)(in, out, groupChannels, segmentLength, envelopeFollower, params);
+						}
+
+						continue;
+					}
+				}
+#endif
+
+				for (int channel = 0; channel < detectorChannels; ++channel)
+				{
+					auto& envelopeFollower = channelState[channel].envelopeFollower;
+
+					if (autoTiming)
+						envelopeFollower.setCoefficients((SampleType)m_autoAttackCoef.getSample(channel, period), (SampleType)m_autoReleaseCoef.getSample(channel, period));
+
+					if (m_blockPath[channel] == IdlePath)
+						envelopeFollower.decay(segmentLength);
+					else
+						(this->*kernel)(detectorIn[channel] + offset, gainCurve[channel] + offset, segmentLength, envelopeFollower, params);
+				}
+			}
+
+			// Gain curve from the smoothed level
+			if (architecture != architecture::LogDomain)
+			{
+				for (int channel = 0; channel < detectorChannels; ++channel)
+					if (m_blockPath[channel] == FullPath)
+						computeGain(gainCurve[channel], gainCurve[channel]);
+			}
+
+			timer.lap(ProfileFrame::Detector);
+
+			SampleType* gainLinear = state.gain.getWritePointer(0);
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				const blockPath path = m_blockPath[std::min(channel, detectorChannels - 1)];
+				const bool unityGain = path == UnityGain || path == IdlePath;
+
+				// Linked channels share the gain of the first
+				if (channel < detectorChannels && unityGain)
+				{
+					// Curve for the meters and the editor, the linear gain only matters while Mix or Volume ramp
+					std::fill(gainCurve[channel], gainCurve[channel] + length, SampleType(0));
+
+					if (gainRamping)
+					{
+						FastMath::transform(mixRamp, volumeRamp, gainLinear, length, [](auto mix, auto volume)
+						{
+							using Type = decltype(volume);
+							return volume * (mix + (Type(1.0f) - mix));
+						});
+					}
+				}
+				else if (channel < detectorChannels)
+				{
+					// Meter gain reduction
+					float gainReductionPeak = m_meterFrame.gainReductionPeakdB;
+					for (int sample = 0; sample < length; ++sample)
+					{
+						const float gainReduction = (float)std::abs(gainCurve[channel][sample]);
+						gainReductionPeak = std::max(gainReductionPeak, gainReduction);
+						gainReductionSum += gainReduction;
+					}
+					m_meterFrame.gainReductionPeakdB = gainReductionPeak;
+
+					// Gain reduction to linear gain
+					FastMath::decibelsToGain(gainCurve[channel], gainLinear, length);
+
+					// Ramping volume and mix fold into the gain
+					if (gainRamping)
+					{
+						FastMath::transform(gainLinear, mixRamp, volumeRamp, gainLinear, length, [](auto gain, auto mix, auto volume)
+						{
+							using Type = decltype(gain);
+							return volume * (mix * gain + (Type(1.0f) - mix));
+						});
+					}
+				}
+
+				// Apply gain reduction, volume and mix
+				if (gainRamping)
+				{
+					FastMath::transform(channelBuffers[channel], gainLinear, channelBuffers[channel], length, [](auto in, auto gain) { return in * gain; });
+				}
+				else if (unityGain)
+				{
+					// Dry and wet are equal, only the volume is left
+					if (volumeGain != 1.0f)
+					{
+						FastMath::transform(channelBuffers[channel], channelBuffers[channel], length, [=](auto in)
+						{
+							using Type = decltype(in);
+							return in * Type(volumeGain);
+						});
+					}
+				}
+				else
+				{
+					FastMath::transform(channelBuffers[channel], gainLinear, channelBuffers[channel], length, [=](auto in, auto gain)
+					{
+						using Type = decltype(in);
+						return in * (Type(volumeMix) * gain + Type(volumeMixInverse));
+					});
+				}
+			}
+
+			timer.lap(ProfileFrame::GainStage);
+		};
+
+		if (bands > 1)
+		{
+			// Split, every band in its own buffers, then sum back into the channels
+			SampleType* const* bandBuffers = state.bandBuffers.data();
+			state.crossover.process(channelBuffers, bandBuffers, channels, length);
+			timer.lap(ProfileFrame::Crossover);
+
+			for (int band = 0; band < bands; ++band)
+				processBand(band, bandBuffers + band * channels);
+
+			for (int channel = 0; channel < channels; ++channel)
+			{
+				std::copy(bandBuffers[channel], bandBuffers[channel] + length, channelBuffers[channel]);
+
+				for (int band = 1; band < bands; ++band)
+					FastMath::transform(channelBuffers[channel], bandBuffers[band * channels + channel], channelBuffers[channel], length, [](auto sum, auto in) { return sum + in; });
+			}
+
+			timer.lap(ProfileFrame::Crossover);
+		}
+		else
+		{
+			processBand(0, channelBuffers);
+		}
+
+		if (factor > 1)
+			state.oversampler.down(state.channelBuffers.data(), channels, hostLength);
+
+		timer.lap(ProfileFrame::Oversampling);
+
+		// Output loudness before the makeup and without the Volume, which trims on top of it. A closed hop retargets
+		// the gain. The latency of the output shifts it against the input by a few ms, nothing next to the 3 s window
+		if (makeup)
+		{
+			if (autoMakeup && m_loudness.measureOutput(state.channelBuffers.data(), hostLength, m_volumeRamp.getCurrent()))
+				m_makeupRamp.setTarget(decibelsToGain(m_loudness.getMakeupdB()));
+
+			timer.lap(ProfileFrame::Meters);
+
+			if (m_makeupRamp.isRamping())
+			{
+				m_makeupRamp.fill(makeupRamp, hostLength);
+
+				for (int channel = 0; channel < channels; ++channel)
+				{
+					FastMath::transform(state.channelBuffers[channel], makeupRamp, state.channelBuffers[channel], hostLength, [](auto in, auto gain)
+					{
+						using Type = decltype(in);
+						return in * Type(gain);
+					});
+				}
+			}
+			else
+			{
+				const float makeupGain = m_makeupRamp.getCurrent();
+
+				for (int channel = 0; channel < channels; ++channel)
+				{
+					FastMath::transform(state.channelBuffers[channel], state.channelBuffers[channel], hostLength, [=](auto in)
+					{
+						using Type = decltype(in);
+						return in * Type(makeupGain);
+					});
+				}
+			}
+
+			timer.lap(ProfileFrame::GainStage);
+		}
+
+		// Only the float curve is exposed, the last band with several
+		m_gainCurveSamples = std::is_same<SampleType, float>::value ? length : 0;
+		m_gainCurveChannels = detectorChannels;
+	}
+
+	// Average over bands and channels
+	m_meterFrame.gainReductionAveragedB = gainReductionSum / (float)std::max(1, samples * factor * detectorChannels * bands);
+	m_meterFrame.outputPeakdB = gainToDecibels(getPeak(data, channels, samples));
+	m_meterFrame.makeupdB = gainToDecibels(m_makeupRamp.getCurrent());
+	m_meterFrame.shortTermLoudness = autoMakeup ? m_loudness.getShortTermLoudness() : FastMath::minusInfinityDb;
+	m_meterFrame.samples = samples;
+
+	if (m_metering.load(std::memory_order_acquire))
+		m_meterQueue->push(m_meterFrame);
+
+	if (profiling)
+	{
+		timer.lap(ProfileFrame::Meters);
+		timer.finish(samples, m_sampleRate);
+
+		m_profileFrame.channels = channels;
+		m_profileStats.add(m_profileFrame.load);
+		m_profileQueue->push(m_profileFrame);
+	}
+}
+
+void CompressorEngine::setProfiling(bool enabled)
+{
+	// Calibrates here rather than in the first profiled block
+	if (enabled)
+	{
+		Profiler::getTicksPerSecond();
+
+		if (m_profileQueue == nullptr)
+			m_profileQueue = std::make_unique<MeterQueue<ProfileFrame, 1024>>();
+	}
+
+	m_profiling.store(enabled, std::memory_order_release);
+}
+
+void CompressorEngine::setMetering(bool enabled)
+{
+	if (enabled && m_meterQueue == nullptr)
+		m_meterQueue = std::make_unique<MeterQueue<MeterFrame, 2048>>();
+
+	m_metering.store(enabled, std::memory_order_release);
+}
+
+bool CompressorEngine::popMeterFrames(MeterFrame& frame)
+{
+	MeterFrame next;
+	if (! popMeterFrame(next))
+		return false;
+
+	frame = next;
+	while (popMeterFrame(next))
+		frame.merge(next);
+
+	return true;
+}
+
+template<typename SampleType>
+float CompressorEngine::getPeak(const SampleType* const* data, int channels, int samples)
+{
+	SampleType peak = SampleType(0);
+
+	for (int channel = 0; channel < channels; ++channel)
+		peak = std::max(peak, FastMath::peak(data[channel], samples));
+
+	return (float)peak;
+}
+
+//==============================================================================
+CompressorEngine::blockPath CompressorEngine::getBlockPath(architecture architecture, double levelPeak, double envelopeLevel, float threshold)
+{
+	// Same dB conversion as the gain computer, with headroom for its approximation
+	auto belowThreshold = [=](double level) { return FastMath::gainToDecibels(level + 0.000001) < (double)(threshold - IDLE_THRESHOLD_MARGIN_DB); };
+
+	// The gain computer outputs 0 dB, the detector smooths zeros and its state is the gain reduction
+	if (architecture == architecture::LogDomain)
+	{
+		if (! belowThreshold(levelPeak))
+			return FullPath;
+
+		return (envelopeLevel < IDLE_GAIN_REDUCTION_DB) ? IdlePath : SilentDetectorInput;
+	}
+
+	// The smoothed level never exceeds the larger of the input and the state
+	if (! belowThreshold(std::max(levelPeak, envelopeLevel)))
+		return FullPath;
+
+	return (levelPeak <= SILENCE_LEVEL) ? IdlePath : UnityGain;
+}
+
+template<typename SampleType>
+double CompressorEngine::getEnvelopeLevel(int band, int channel, bool lanes)
+{
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	if (std::is_same<SampleType, float>::value && lanes)
+	{
+		float levels[EnvelopeFollowerLanes::LANES];
+		m_laneGroupState[band * m_laneGroups + channel / EnvelopeFollowerLanes::LANES].envelopeFollower.getLevel().store(levels);
+
+		return levels[channel % EnvelopeFollowerLanes::LANES];
+	}
+#endif
+
+	auto& state = getSampleState<SampleType>();
+	const int channels = (int)state.channelState.size() / MAX_BANDS;
+
+	return (double)state.channelState[band * channels + channel].envelopeFollower.getLevel();
+}
+
+//==============================================================================
+template<typename SampleType>
+void CompressorEngine::linkLevels(const SampleType* const* in, SampleType* level, int channels, int samples, channelLink link, const float* weights)
+{
+	using FastMath::abs;
+	using FastMath::max;
+
+	if (link == channelLink::Max)
+	{
+		FastMath::transform(in[0], level, samples, [](auto in) { return abs(in); });
+
+		for (int channel = 1; channel < channels; ++channel)
+			FastMath::transform(level, in[channel], level, samples, [](auto level, auto in) { return max(level, abs(in)); });
+	}
+	else
+	{
+		// Mean is the weighted sum with equal weights
+		const float equalWeight = 1.0f / channels;
+
+		auto weight = [=](int channel) { return (link == channelLink::Weighted) ? weights[channel] : equalWeight; };
+
+		const float firstWeight = weight(0);
+		FastMath::transform(in[0], level, samples, [=](auto in)
+		{
+			using Type = decltype(in);
+			return Type(firstWeight) * abs(in);
+		});
+
+		for (int channel = 1; channel < channels; ++channel)
+		{
+			const float channelWeight = weight(channel);
+			FastMath::transform(level, in[channel], level, samples, [=](auto level, auto in)
+			{
+				using Type = decltype(in);
+				return level + Type(channelWeight) * abs(in);
+			});
+		}
+	}
+}
+
+//==============================================================================
+template<typename SampleType>
+void CompressorEngine::gainComputer(const SampleType* level, SampleType* gaindB, int samples, float threshold, float R_Inv_minus_One)
+{
+	FastMath::transform(level, gaindB, samples, [=](auto in)
+	{
+		using Type = decltype(in);
+		using FastMath::abs;
+		using FastMath::selectGreater;
+
+		// Convert input from gain to dB
+		const Type indB = FastMath::gainToDecibels(abs(in) + Type(0.000001f));
+
+		//Get gain reduction, positive values
+		return selectGreater(Type(threshold), indB, Type(0.0f), (indB - Type(threshold)) * Type(R_Inv_minus_One));
+	});
+}
+
+template<typename SampleType>
+void CompressorEngine::gainComputer(const SampleType* level, SampleType* gaindB, int samples, const float* threshold, const float* R_Inv_minus_One)
+{
+	FastMath::transform(level, threshold, R_Inv_minus_One, gaindB, samples, [](auto in, auto threshold, auto R_Inv_minus_One)
+	{
+		using Type = decltype(in);
+		using FastMath::abs;
+		using FastMath::selectGreater;
+
+		const Type indB = FastMath::gainToDecibels(abs(in) + Type(0.000001f));
+
+		// Ramps stay float, a double level promotes them
+		return selectGreater(Type(threshold), indB, Type(0.0f), (indB - Type(threshold)) * Type(R_Inv_minus_One));
+	});
+}
+
+//==============================================================================
+template<CompressorEngine::architecture arch, EnvelopeFollower::ballisticType type, typename SampleType>
+void CompressorEngine::processKernel(const SampleType* in, SampleType* out, int samples, EnvelopeFollowerT<SampleType>& envelopeFollower, const KernelParams& params)
+{
+	const SampleType thresholdGain = params.thresholdGain;
+	const SampleType factor = params.factor;
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		// ReturnToThreshold holds the detector input at threshold
+		const SampleType detectorIn = (arch == architecture::ReturnToThreshold) ? std::fmax(thresholdGain, in[sample]) : in[sample];
+
+		// Smooth
+		const SampleType smooth = envelopeFollower.template process<type>(detectorIn);
+
+		out[sample] = (arch == architecture::LogDomain) ? factor * smooth : smooth;
+	}
+}
+
+// Indexed by [architecture - 1][ballisticType - 1]
+template<typename SampleType>
+const CompressorEngine::Kernel<SampleType> CompressorEngine::kernels[3][4] =
+{
+	{
+		&CompressorEngine::processKernel<architecture::ReturnToZero, EnvelopeFollower::ballisticType::Decoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToZero, EnvelopeFollower::ballisticType::Branching, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToZero, EnvelopeFollower::ballisticType::SmoothDecoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToZero, EnvelopeFollower::ballisticType::SmoothBranching, SampleType>
+	},
+	{
+		&CompressorEngine::processKernel<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::Decoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::Branching, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::SmoothDecoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::SmoothBranching, SampleType>
+	},
+	{
+		&CompressorEngine::processKernel<architecture::LogDomain, EnvelopeFollower::ballisticType::Decoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::LogDomain, EnvelopeFollower::ballisticType::Branching, SampleType>,
+		&CompressorEngine::processKernel<architecture::LogDomain, EnvelopeFollower::ballisticType::SmoothDecoupled, SampleType>,
+		&CompressorEngine::processKernel<architecture::LogDomain, EnvelopeFollower::ballisticType::SmoothBranching, SampleType>
+	}
+};
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+//==============================================================================
+template<CompressorEngine::architecture arch, EnvelopeFollower::ballisticType type>
+void CompressorEngine::processKernelLanes(const float* const* in, float* const* out, int channels, int samples, EnvelopeFollowerLanes& envelopeFollower, const KernelParams& params)
+{
+	using FastMath::Vec4;
+
+	const Vec4 thresholdGain = params.thresholdGain;
+	const Vec4 factor = params.factor;
+
+	// Local copy keeps the state in registers, the buffers could alias it otherwise
+	EnvelopeFollowerLanes envelope = envelopeFollower;
+
+	// Unused lanes read silence and write to scratch
+	const float* inputs[EnvelopeFollowerLanes::LANES];
+	float* outputs[EnvelopeFollowerLanes::LANES];
+
+	for (int lane = 0; lane < EnvelopeFollowerLanes::LANES; ++lane)
+	{
+		inputs[lane] = (lane < channels) ? in[lane] : m_laneSilence.data();
+		outputs[lane] = (lane < channels) ? out[lane] : m_laneScratch.data();
+	}
+
+	for (int sample = 0; sample < samples; ++sample)
+	{
+		// Get input, one channel per lane
+		const Vec4 input = Vec4::gather(inputs, sample);
+
+		// ReturnToThreshold holds the detector input at threshold
+		const Vec4 detectorIn = (arch == architecture::ReturnToThreshold) ? max(thresholdGain, input) : input;
+
+		// Smooth
+		const Vec4 smooth = envelope.process<type>(detectorIn);
+
+		((arch == architecture::LogDomain) ? factor * smooth : smooth).scatter(outputs, sample);
+	}
+
+	envelopeFollower = envelope;
+}
+
+// Indexed by [architecture - 1][ballisticType - 1]
+const CompressorEngine::KernelLanes CompressorEngine::kernelsLanes[3][4] =
+{
+	{
+		&CompressorEngine::processKernelLanes<architecture::ReturnToZero, EnvelopeFollower::ballisticType::Decoupled>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToZero, EnvelopeFollower::ballisticType::Branching>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToZero, EnvelopeFollower::ballisticType::SmoothDecoupled>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToZero, EnvelopeFollower::ballisticType::SmoothBranching>
+	},
+	{
+		&CompressorEngine::processKernelLanes<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::Decoupled>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::Branching>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::SmoothDecoupled>,
+		&CompressorEngine::processKernelLanes<architecture::ReturnToThreshold, EnvelopeFollower::ballisticType::SmoothBranching>
+	},
+	{
+		&CompressorEngine::processKernelLanes<architecture::LogDomain, EnvelopeFollower::ballisticType::Decoupled>,
+		&CompressorEngine::processKernelLanes<architecture::LogDomain, EnvelopeFollower::ballisticType::Branching>,
+		&CompressorEngine::processKernelLanes<architecture::LogDomain, EnvelopeFollower::ballisticType::SmoothDecoupled>,
+		&CompressorEngine::processKernelLanes<architecture::LogDomain, EnvelopeFollower::ballisticType::SmoothBranching>
+	}
+};
+#endif
+
+//==============================================================================
+template<typename SampleType>
+void CompressorEngine::timesAutomation(const SampleType* in, int samples, CrestFactorT<SampleType>& crestFactor, float attack, float release, float& attackCoef, float& releaseCoef)
+{
+	for (int sample = 0; sample < samples; ++sample)
+		crestFactor.update(in[sample]);
+
+	const float crestSQ = (float)crestFactor.getCrestFactorSQ();
+	const float crestMultiplier = 1.0f - std::min(crestSQ / 40.0f, 1.0f);
+
+	float attackAuto = attack * crestMultiplier;
+	if (attackAuto <= 0.1f)
+		attackAuto = 0.1f;
+
+	float releaseAuto = release * crestMultiplier;
+	if (releaseAuto <= 30.0f)
+		releaseAuto = 30.0f;
+
+	// Table lookup instead of two exp
+	attackCoef = m_timeCoefficients.get(attackAuto);
+	releaseCoef = m_timeCoefficients.get(releaseAuto);
+
+	// Values for meters
+	m_meterFrame.attackTime = attackAuto;
+	m_meterFrame.releaseTime = releaseAuto;
+
+	if (crestMultiplier * 100.0f > m_meterFrame.crestFactorPercentage)
+		m_meterFrame.crestFactorPercentage = crestMultiplier * 100.0f;
+}
+
@@ -0,0 +1,822 @@
+/*
+  ==============================================================================
+
+    Compressor engine, all the DSP of the plugin without JUCE.
+
+    The plugin, the renderer and the benchmark wrap it through
+    CompressorAudioProcessor, services embed it directly through the C++
+    class or the C interface in CompressorEngineC.h. Only the standard
+    library is used, prepare allocates and process never does.
+
+    Parameters are plain values set from the processing thread before a
+    block, the same ranges as the plugin parameters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "FastMath.h"
+#include "Meters.h"
+#include "Profiler.h"
+#include "Oversampling.h"
+#include "Lookahead.h"
+#include "RunningRms.h"
+#include "Crossover.h"
+#include "KeyFilter.h"
+#include "Loudness.h"
+
+//==============================================================================
+// Ballistic types and the filter step shared by the float, double and SIMD followers
+class EnvelopeFollowerBase
+{
+public:
+	enum ballisticType
+	{
+		Decoupled = 1,
+		Branching,
+		SmoothDecoupled,
+		SmoothBranching
+	};
+
+	// One pole coefficient for a time in ms
+	template<typename Type>
+	static Type timeToCoefficient(Type timeMs, int sampleRate) { return exp(Type(-1000.0f) / (timeMs * sampleRate)); }
+
+	template<ballisticType type, typename Type> static inline Type step(Type inAbs, Type& outLast, Type& out1Last, Type attackCoef, Type releaseCoef);
+
+	// samples steps of zero input in closed form, Type is float or double
+	template<typename Type> static void decay(ballisticType type, int samples, Type& outLast, Type& out1Last, Type attackCoef, Type releaseCoef);
+};
+
+// Shared by the scalar and SIMD followers, Type is float, double or FastMath::Vec4
+template<EnvelopeFollowerBase::ballisticType type, typename Type>
+inline Type EnvelopeFollowerBase::step(Type inAbs, Type& outLast, Type& out1Last, Type attackCoef, Type releaseCoef)
+{
+	using FastMath::max;
+	using FastMath::selectGreater;
+
+	if (type == ballisticType::Decoupled)
+	{
+		out1Last = max(inAbs, releaseCoef * out1Last);
+		return outLast = attackCoef * outLast + (Type(1.0f) - attackCoef) * out1Last;
+	}
+	else if (type == ballisticType::Branching)
+	{
+		return outLast = selectGreater(inAbs, outLast, attackCoef * outLast + (Type(1.0f) - attackCoef) * inAbs, releaseCoef * outLast);
+	}
+	else if (type == ballisticType::SmoothDecoupled)
+	{
+		out1Last = max(inAbs, releaseCoef * out1Last + (Type(1.0f) - releaseCoef) * inAbs);
+		return outLast = attackCoef * outLast + (Type(1.0f) - attackCoef) * out1Last;
+	}
+	else
+	{
+		const Type coef = selectGreater(inAbs, outLast, attackCoef, releaseCoef);
+		return outLast = coef * outLast + (Type(1.0f) - coef) * inAbs;
+	}
+}
+
+// With no input every type releases. The branching types are a single pole, the decoupled types
+// feed the released peak through the attack pole: out += (1 - a) * out1 * sum of a^(n - k) r^k, k = 1..n
+template<typename Type>
+void EnvelopeFollowerBase::decay(ballisticType type, int samples, Type& outLast, Type& out1Last, Type attackCoef, Type releaseCoef)
+{
+	const Type releasePower = FastMath::powInt(releaseCoef, samples);
+
+	if (type == ballisticType::Branching || type == ballisticType::SmoothBranching)
+	{
+		outLast *= releasePower;
+		return;
+	}
+
+	const Type attackPower = FastMath::powInt(attackCoef, samples);
+	const Type difference = attackCoef - releaseCoef;
+
+	// Nearly equal poles cancel in the quotient, n * max^n bounds the sum from above
+	const Type sum = (std::abs(difference) > Type(1.0e-3f)) ? releaseCoef * (attackPower - releasePower) / difference
+	                                                         : Type(samples) * FastMath::powInt(std::max(attackCoef, releaseCoef), samples);
+
+	outLast = attackPower * outLast + (Type(1.0f) - attackCoef) * sum * out1Last;
+	out1Last *= releasePower;
+}
+
+//==============================================================================
+// SampleType float or double, the double state keeps long releases at high rates exact
+template<typename SampleType>
+class EnvelopeFollowerT : public EnvelopeFollowerBase
+{
+public:
+	void init(int sampleRate) { m_SampleRate = sampleRate; }
+	void setCoef(SampleType attackTimeMs, SampleType releaseTimeMs)
+	{
+		m_AttackCoef = timeToCoefficient(attackTimeMs, m_SampleRate);
+		m_ReleaseCoef = timeToCoefficient(releaseTimeMs, m_SampleRate);
+	}
+	void setCoefficients(SampleType attackCoef, SampleType releaseCoef) { m_AttackCoef = attackCoef; m_ReleaseCoef = releaseCoef; }
+	void setBallisticType(ballisticType ballisticType) { m_ballisticType = ballisticType; }
+
+	SampleType process(SampleType in)
+	{
+		switch (m_ballisticType)
+		{
+		case ballisticType::Decoupled:       return process<ballisticType::Decoupled>(in);
+		case ballisticType::Branching:       return process<ballisticType::Branching>(in);
+		case ballisticType::SmoothDecoupled: return process<ballisticType::SmoothDecoupled>(in);
+		case ballisticType::SmoothBranching: return process<ballisticType::SmoothBranching>(in);
+		}
+
+		return SampleType(0);
+	}
+
+	// Ballistic type is resolved at compile time, so the kernels in processBlock inline a single filter
+	template<ballisticType type>
+	inline SampleType process(SampleType in)
+	{
+		return step<type>(std::abs(in), m_OutLast, m_Out1Last, m_AttackCoef, m_ReleaseCoef);
+	}
+
+	// Same state as samples of silence, without the per sample recursion
+	void decay(int samples) { EnvelopeFollowerBase::decay(m_ballisticType, samples, m_OutLast, m_Out1Last, m_AttackCoef, m_ReleaseCoef); }
+
+	// No later output of silent input exceeds it
+	SampleType getLevel() const { return std::max(m_OutLast, m_Out1Last); }
+
+protected:
+	ballisticType m_ballisticType = ballisticType::SmoothBranching;
+	int  m_SampleRate = 48000;
+	SampleType m_AttackCoef = 0;
+	SampleType m_ReleaseCoef = 0;
+
+	SampleType m_OutLast = 0;
+	SampleType m_Out1Last = 0;
+};
+
+using EnvelopeFollower = EnvelopeFollowerT<float>;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+//==============================================================================
+// Envelope follower for up to 4 channels, structure-of-arrays state with one channel per lane
+class EnvelopeFollowerLanes
+{
+public:
+	static constexpr int LANES = 4;
+
+	void init(int sampleRate) { m_SampleRate = sampleRate; }
+	void setCoef(float attackTimeMs, float releaseTimeMs)
+	{
+		m_AttackCoef = EnvelopeFollowerBase::timeToCoefficient(attackTimeMs, m_SampleRate);
+		m_ReleaseCoef = EnvelopeFollowerBase::timeToCoefficient(releaseTimeMs, m_SampleRate);
+	}
+	void setCoefficients(FastMath::Vec4 attackCoef, FastMath::Vec4 releaseCoef) { m_AttackCoef = attackCoef; m_ReleaseCoef = releaseCoef; }
+
+	template<EnvelopeFollower::ballisticType type>
+	inline FastMath::Vec4 process(FastMath::Vec4 in)
+	{
+		return EnvelopeFollowerBase::step<type>(abs(in), m_OutLast, m_Out1Last, m_AttackCoef, m_ReleaseCoef);
+	}
+
+	// Closed form silence for every lane, once per block so the lanes run scalar
+	void decay(EnvelopeFollowerBase::ballisticType type, int samples)
+	{
+		float outLast[LANES], out1Last[LANES], attackCoef[LANES], releaseCoef[LANES];
+		m_OutLast.store(outLast);
+		m_Out1Last.store(out1Last);
+		m_AttackCoef.store(attackCoef);
+		m_ReleaseCoef.store(releaseCoef);
+
+		for (int lane = 0; lane < LANES; ++lane)
+			EnvelopeFollowerBase::decay(type, samples, outLast[lane], out1Last[lane], attackCoef[lane], releaseCoef[lane]);
+
+		m_OutLast = FastMath::Vec4::load(outLast);
+		m_Out1Last = FastMath::Vec4::load(out1Last);
+	}
+
+	FastMath::Vec4 getLevel() const { return max(m_OutLast, m_Out1Last); }
+
+protected:
+	int  m_SampleRate = 48000;
+	FastMath::Vec4 m_AttackCoef{ 0.0f };
+	FastMath::Vec4 m_ReleaseCoef{ 0.0f };
+
+	FastMath::Vec4 m_OutLast{ 0.0f };
+	FastMath::Vec4 m_Out1Last{ 0.0f };
+};
+#endif
+
+//==============================================================================
+// exp(-1000 / (time * sampleRate)) on a log2 time grid, replaces the exp calls of per sample coefficient updates
+class TimeCoefficientTable
+{
+public:
+	static constexpr int OCTAVES = 11;
+	static constexpr int STEPS_PER_OCTAVE = 64;
+	static constexpr int SIZE = OCTAVES * STEPS_PER_OCTAVE + 1;
+
+	// Covers 0.1 ms to 204.8 ms, times outside are clamped
+	static constexpr float MIN_TIME_MS = 0.1f;
+
+	void init(int sampleRate);
+
+	inline float get(float timeMs) const
+	{
+		const float position = std::clamp(FastMath::log2(timeMs * (1.0f / MIN_TIME_MS)) * STEPS_PER_OCTAVE, 0.0f, (float)(SIZE - 1));
+		const int index = std::min((int)position, SIZE - 2);
+		const float fraction = position - (float)index;
+
+		return m_table[index] + fraction * (m_table[index + 1] - m_table[index]);
+	}
+
+protected:
+	std::array<float, SIZE> m_table{};
+};
+
+//==============================================================================
+template<typename SampleType>
+class CrestFactorT
+{
+public:
+	void init(int sampleRate) { m_SampleRate = sampleRate; }
+	void setCoef(SampleType time) { m_Coef = exp(SampleType(-1.0f) / (m_SampleRate * time)); }
+
+	SampleType process(SampleType in)
+	{
+		update(in);
+
+		return std::sqrt(getCrestFactorSQ());
+	}
+
+	// Per sample part of process, the ratio is only needed at control rate
+	inline void update(SampleType in)
+	{
+		const SampleType inSQ = in * in;
+		const SampleType inFactor = (SampleType(1.0f) - m_Coef) * inSQ;
+
+		m_PeakLastSQ = std::max(inSQ, m_Coef * m_PeakLastSQ + inFactor);
+		m_RMSLastSQ = m_Coef * m_RMSLastSQ + inFactor;
+	}
+
+	// Squared crest factor, zero for silence
+	SampleType getCrestFactorSQ() const { return m_PeakLastSQ / std::max(m_RMSLastSQ, SampleType(FastMath::minNormal)); }
+
+protected:
+	int  m_SampleRate = 48000;
+	SampleType m_Coef = 0;
+
+	SampleType m_PeakLastSQ = 0;
+	SampleType m_RMSLastSQ = 0;
+};
+
+using CrestFactor = CrestFactorT<float>;
+
+//==============================================================================
+// Moves a parameter to its latest target over a fixed time, linear or multiplicative for gains.
+// Filled a block at a time, the target is held once reached
+template<bool multiplicative>
+class ParameterRamp
+{
+public:
+	// Keeps the current value, a running ramp jumps to its target
+	void init(int sampleRate, float rampTimeMs)
+	{
+		m_rampSamples = std::max(1, (int)(rampTimeMs * 0.001f * sampleRate));
+		setCurrentAndTarget(m_target);
+	}
+
+	void setCurrentAndTarget(float value)
+	{
+		m_current = m_target = value;
+		m_remaining = 0;
+	}
+
+	void setTarget(float target)
+	{
+		if (target == m_target)
+			return;
+
+		m_target = target;
+		m_remaining = m_rampSamples;
+		m_step = multiplicative ? std::pow(target / m_current, 1.0f / m_rampSamples) : (target - m_current) / m_rampSamples;
+	}
+
+	bool isRamping() const { return m_remaining > 0; }
+
+	// Value of the last filled sample
+	float getCurrent() const { return m_current; }
+
+	void fill(float* out, int samples)
+	{
+		const int rampSamples = std::min(samples, m_remaining);
+		int sample = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		using FastMath::Vec4;
+
+		// Steps 1 to 4 from the current value, then 4 steps per iteration
+		const float step2 = multiplicative ? m_step * m_step : 2.0f * m_step;
+		const float steps[4] = { m_step, step2, multiplicative ? step2 * m_step : 3.0f * m_step, multiplicative ? step2 * step2 : 2.0f * step2 };
+		const Vec4 increment(steps[3]);
+		Vec4 value = multiplicative ? Vec4(m_current) * Vec4::load(steps) : Vec4(m_current) + Vec4::load(steps);
+
+		for (; sample + 4 <= rampSamples; sample += 4)
+		{
+			value.store(out + sample);
+			value = multiplicative ? value * increment : value + increment;
+		}
+#endif
+
+		for (; sample < rampSamples; ++sample)
+			out[sample] = multiplicative ? m_current * std::pow(m_step, (float)(sample + 1)) : m_current + m_step * (float)(sample + 1);
+
+		m_remaining -= rampSamples;
+
+		// Ends exactly on the target, no drift from the accumulation
+		if (rampSamples > 0)
+			m_current = (m_remaining == 0) ? m_target : out[rampSamples - 1];
+
+		std::fill(out + rampSamples, out + samples, m_target);
+	}
+
+protected:
+	int m_rampSamples = 1;
+	int m_remaining = 0;
+	float m_current = 0.0f;
+	float m_target = 0.0f;
+	float m_step = 0.0f;
+};
+
+//==============================================================================
+// Planar sample storage, a minimal stand-in for juce::AudioBuffer. Allocates in setSize only
+template<typename SampleType>
+class SampleBuffer
+{
+public:
+	void setSize(int channels, int samples)
+	{
+		m_channels = channels;
+		m_samples = samples;
+		m_data.assign((size_t)channels * (size_t)samples, SampleType(0));
+	}
+
+	void clear() { std::fill(m_data.begin(), m_data.end(), SampleType(0)); }
+
+	int getNumChannels() const { return m_channels; }
+	int getNumSamples() const { return m_samples; }
+
+	SampleType* getWritePointer(int channel) { return m_data.data() + (size_t)channel * (size_t)m_samples; }
+	const SampleType* getReadPointer(int channel) const { return m_data.data() + (size_t)channel * (size_t)m_samples; }
+	SampleType getSample(int channel, int sample) const { return getReadPointer(channel)[sample]; }
+
+private:
+	int m_channels = 0;
+	int m_samples = 0;
+	std::vector<SampleType> m_data;
+};
+
+//==============================================================================
+class CompressorEngine
+{
+public:
+	enum architecture
+	{
+		ReturnToZero = 1,
+		ReturnToThreshold,
+		LogDomain,
+	};
+
+	enum automation
+	{
+		Manual = 1,
+		Auto,
+	};
+
+	// Link choice index + 1
+	enum channelLink
+	{
+		Unlinked = 1,
+		Max,
+		Mean,
+		Weighted,
+	};
+
+	// Detector choice index + 1
+	enum detector
+	{
+		Peak = 1,
+		Rms,
+		Hybrid,     // Mean of peak and RMS
+	};
+
+	// Key filter choice index + 1
+	enum keyFilterType
+	{
+		Unfiltered = 1,
+		HighPass,
+		BandPass,
+	};
+
+	// Samples between auto attack and release updates
+	static constexpr int CONTROL_PERIOD = 32;
+
+	static constexpr float MAX_LOOKAHEAD_MS = 20.0f;
+
+	static constexpr float MIN_RMS_WINDOW_MS = 1.0f;
+	static constexpr float MAX_RMS_WINDOW_MS = 100.0f;
+
+	// Fast path for blocks that leave the gain at 0 dB. Levels below SILENCE_LEVEL count as silence,
+	// the detector of a silent channel decays in closed form once its gain reduction is below
+	// IDLE_GAIN_REDUCTION_DB, well under the error of the dB approximations
+	static constexpr float SILENCE_LEVEL = 1.0e-9f;
+	static constexpr float IDLE_GAIN_REDUCTION_DB = 0.0001f;
+
+	// Headroom to the threshold covering the dB approximation of the gain computer
+	static constexpr float IDLE_THRESHOLD_MARGIN_DB = 0.05f;
+
+	// Threshold, Ratio, Mix and Volume glide to new values over this time
+	static constexpr float PARAMETER_RAMP_MS = 20.0f;
+
+	// Auto makeup glides to each new gain over this time, the gain moves once per 100 ms loudness hop
+	static constexpr float MAKEUP_RAMP_MS = 500.0f;
+
+	static constexpr int MAX_BANDS = Crossover<float>::MAX_BANDS;
+	static constexpr float MAX_BAND_THRESHOLD_DB = 24.0f;
+
+	// Modes A-D of the plugin buttons
+	static constexpr int MODES = 4;
+
+	// Architecture and ballistic type of mode 0-3 (A-D)
+	static void getMode(int mode, architecture& architecture, EnvelopeFollower::ballisticType& ballisticType);
+
+	// Architecture and ballistic type of every band
+	struct BandModes
+	{
+		architecture architectures[MAX_BANDS];
+		EnvelopeFollower::ballisticType ballisticTypes[MAX_BANDS];
+	};
+
+	// Plain parameter values, defaults and ranges of the plugin parameters
+	struct Parameters
+	{
+		float attack = 10.0f;             // ms, 0.1 to 80
+		float release = 100.0f;           // ms, 1 to 200
+		float ratio = 4.0f;               // 0.6 to 8
+		float threshold = -12.0f;         // dB, -60 to 12
+		float mix = 1.0f;                 // 0 to 1
+		float volume = 0.0f;              // dB, -24 to 24, a trim on top of the auto makeup
+		bool autoMakeup = false;          // Gain keeps the output loudness at the input loudness, see Loudness.h
+		float lookahead = 0.0f;           // ms, 0 to MAX_LOOKAHEAD_MS
+		channelLink link = Unlinked;
+		automation timing = Manual;
+		detector detection = Peak;
+		float rmsWindow = 10.0f;          // ms, MIN_RMS_WINDOW_MS to MAX_RMS_WINDOW_MS
+		bool sidechain = false;           // Key given to process drives the detectors, else the channels do
+		keyFilterType keyFilter = Unfiltered;
+		float keyFrequency = 1000.0f;     // Hz, 20 to 20000
+		int oversampling = 0;             // 2x stages, 0 to 3
+		int bands = 1;                    // 1 to MAX_BANDS
+		float crossovers[MAX_BANDS - 1] = { 120.0f, 500.0f, 2000.0f, 6000.0f };  // Hz, kept ascending
+		float bandThresholds[MAX_BANDS] = {};                                     // dB offsets to threshold
+		BandModes modes;
+
+		// Mode A on every band
+		Parameters();
+	};
+
+	//==============================================================================
+	// Allocates for the layout and the largest block, resets all state. Only the given precision is allocated.
+	// keyChannels is the most sidechain channels process will get, 0 without a sidechain.
+	// RMS windows are allocated for the current Detector, Oversampling and Bands, see needsPrepare, or for all of
+	// them after setMaxRmsWindows(true)
+	void prepare(double sampleRate, int maxBlockSize, int channels, bool doublePrecision = false, int keyChannels = 0);
+
+	// True when the parameters need longer RMS windows than prepare allocated, RMS or Hybrid after Peak, a higher
+	// oversampling factor or more bands. Windows are shortened to what fits, down to the peak level, until
+	// prepare runs again off the processing thread
+	bool needsPrepare() const;
+
+	// From the next prepare on, RMS windows for the longest window at the highest factor in every band, so no
+	// parameter ever needs a new prepare. For hosts that change them while playing, off by default
+	void setMaxRmsWindows(bool enabled) { m_maxRmsWindows = enabled; }
+
+	// Clears filters, detectors and delays, keeps the parameters
+	void reset();
+
+	bool isPrepared() const { return m_blockSize > 0; }
+	int getNumChannels() const { return m_channels; }
+	int getNumKeyChannels() const { return m_keyChannels; }
+	double getSampleRate() const { return m_sampleRate; }
+
+	// Values outside the ranges are clamped. Same thread as process
+	void setParameters(const Parameters& parameters);
+	const Parameters& getParameters() const { return m_parameters; }
+
+	// Weighted link gains, one per channel, normalized to unity sum. Equal weights after prepare
+	void setLinkWeights(const float* weights);
+
+	// In place, channels planar buffers of samples each. Any length, long blocks run in sub-blocks
+	void process(float* const* channels, int numChannels, int samples);
+	void process(double* const* channels, int numChannels, int samples);
+
+	// Same, the detectors read key while Parameters::sidechain is set. key is only read, straight from the
+	// given buffers unless oversampled or filtered. A key of numChannels channels keys every channel and
+	// follows the link, any other count is linked, one detector on its Max or Mean drives all channels
+	void process(float* const* channels, int numChannels, int samples, const float* const* key, int keyChannels);
+	void process(double* const* channels, int numChannels, int samples, const double* const* key, int keyChannels);
+
+	// In place on interleaved samples, deinterleaved through the preallocated stage buffers
+	void processInterleaved(float* data, int samples);
+
+	// Oversampling filters plus look-ahead, in samples at the base rate
+	int getLatencySamples() const { return m_latencySamples; }
+
+	// Crest factor driven attack and release for the next control period, coefficients out
+	template<typename SampleType>
+	void timesAutomation(const SampleType* in, int samples, CrestFactorT<SampleType>& crestFactor, float attack, float release, float& attackCoef, float& releaseCoef);
+
+	// Per block constants shared by the detector kernels
+	struct KernelParams
+	{
+		float thresholdGain;
+		float factor;
+	};
+
+	// Converts level to dB and applies the static curve, gain reduction in dB out
+	template<typename SampleType>
+	static void gainComputer(const SampleType* level, SampleType* gaindB, int samples, float threshold, float R_Inv_minus_One);
+
+	// Same with per sample threshold and slope while they ramp
+	template<typename SampleType>
+	static void gainComputer(const SampleType* level, SampleType* gaindB, int samples, const float* threshold, const float* R_Inv_minus_One);
+
+	template<architecture arch, EnvelopeFollower::ballisticType type, typename SampleType>
+	void processKernel(const SampleType* in, SampleType* out, int samples, EnvelopeFollowerT<SampleType>& envelopeFollower, const KernelParams& params);
+
+	template<typename SampleType>
+	using Kernel = void (CompressorEngine::*)(const SampleType*, SampleType*, int, EnvelopeFollowerT<SampleType>&, const KernelParams&);
+
+	template<typename SampleType>
+	static const Kernel<SampleType> kernels[3][4];
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	// Up to 4 channels processed as lanes of one vector, larger layouts run one group of 4 at a time
+	template<architecture arch, EnvelopeFollower::ballisticType type>
+	void processKernelLanes(const float* const* in, float* const* out, int channels, int samples, EnvelopeFollowerLanes& envelopeFollower, const KernelParams& params);
+
+	using KernelLanes = void (CompressorEngine::*)(const float* const*, float* const*, int, int, EnvelopeFollowerLanes&, const KernelParams&);
+	static const KernelLanes kernelsLanes[3][4];
+#endif
+
+	// Combines the rectified channels into one detector level, weights only used by Weighted
+	template<typename SampleType>
+	static void linkLevels(const SampleType* const* in, SampleType* level, int channels, int samples, channelLink link, const float* weights);
+
+	// Gain reduction in dB of the last processed samples at the oversampled rate, float processing only, processing thread only
+	const SampleBuffer<float>& getGainCurve() const { return m_floatState.gainCurve; }
+	int getGainCurveSamples() const { return m_gainCurveSamples; }
+	int getGainCurveChannels() const { return m_gainCurveChannels; }
+
+	// Meter frames of processed blocks, off by default so engines of a bank carry no queue. Enabling allocates
+	// the queue the first time, so not from the processing thread, and before the consumer starts
+	void setMetering(bool enabled);
+	bool isMetering() const { return m_metering.load(std::memory_order_relaxed); }
+
+	// One consumer, editor or logger
+	bool popMeterFrame(MeterFrame& frame) { return m_meterQueue != nullptr && m_meterQueue->pop(frame); }
+
+	// All pending frames merged into one, false when none are ready
+	bool popMeterFrames(MeterFrame& frame);
+
+	// Timing of every process call, off by default. Enabling calibrates the cycle counter and allocates the frame
+	// queue the first time, so not from the processing thread
+	void setProfiling(bool enabled);
+	bool isProfiling() const { return m_profiling.load(std::memory_order_relaxed); }
+
+	// Profile frames of processed blocks, one consumer. Frames are dropped when it falls behind, the stats never
+	bool popProfileFrame(ProfileFrame& frame) { return m_profileQueue != nullptr && m_profileQueue->pop(frame); }
+	const ProfileStats& getProfileStats() const { return m_profileStats; }
+	ProfileStats& getProfileStats() { return m_profileStats; }
+
+	// Same conversions as juce::Decibels, exact library functions
+	static float decibelsToGain(float dB) { return (dB > FastMath::minusInfinityDb) ? std::pow(10.0f, dB * 0.05f) : 0.0f; }
+	static float gainToDecibels(float gain) { return (gain > 0.0f) ? std::max(FastMath::minusInfinityDb, std::log10(gain) * 20.0f) : FastMath::minusInfinityDb; }
+
+private:
+	//==============================================================================
+	static const int CACHE_LINE_SIZE = 64;
+
+	// Per channel detector state, one cache line each so neighbours never share
+	template<typename SampleType>
+	struct alignas(CACHE_LINE_SIZE) ChannelState
+	{
+		EnvelopeFollowerT<SampleType> envelopeFollower;
+		CrestFactorT<SampleType> crestFactor;
+		SlidingMaximum<SampleType> slidingMaximum;
+		DelayLine<SampleType> delayLine;
+		RunningRms<SampleType> runningRms;
+	};
+
+	// Everything that holds samples. Sized for the layout in prepare, process never allocates
+	template<typename SampleType>
+	struct SampleState
+	{
+		// Band major, band * channels + channel
+		std::vector<ChannelState<SampleType>> channelState;
+		Oversampler<SampleType> oversampler;
+		Crossover<SampleType> crossover;
+
+		// Sub-block pointers into the processed buffer and the gain curve
+		std::vector<SampleType*> channelBuffers;
+		std::vector<SampleType*> gainCurveBuffers;
+
+		// Crossover outputs, band major like channelState
+		std::vector<SampleType*> bandBuffers;
+
+		// Sidechain key at the oversampled rate, filtered into key for the sidechain or, one filter per band,
+		// for the band signals
+		Oversampler<SampleType> keyOversampler;
+		std::vector<KeyFilter<SampleType>> keyFilters;
+		std::vector<const SampleType*> keyBuffers;
+		std::vector<SampleType*> filteredKeyBuffers;
+		SampleBuffer<SampleType> key;
+
+		// Stage buffers, preallocated for the highest oversampling factor
+		SampleBuffer<SampleType> gainCurve;
+		SampleBuffer<SampleType> gain;
+		SampleBuffer<SampleType> bands;
+	};
+
+	// Only the prepared precision is allocated
+	SampleState<float> m_floatState;
+	SampleState<double> m_doubleState;
+
+	template<typename SampleType>
+	SampleState<SampleType>& getSampleState()
+	{
+		if constexpr (std::is_same<SampleType, float>::value)
+			return m_floatState;
+		else
+			return m_doubleState;
+	}
+
+	template<typename SampleType>
+	void prepareSampleState(SampleState<SampleType>& state, int channels, int keyChannels, int samplesPerBlock);
+
+	// Shared body of the float and double process
+	template<typename SampleType>
+	void processSamples(SampleType* const* data, int numChannels, int samples, const SampleType* const* key = nullptr, int keyChannels = 0);
+
+	// Largest magnitude of all channels, for the meters
+	template<typename SampleType>
+	static float getPeak(const SampleType* const* data, int channels, int samples);
+
+	Parameters m_parameters;
+	int m_channels = 0;
+	int m_keyChannels = 0;
+
+	// Interleaved input, planar at the base rate
+	SampleBuffer<float> m_interleaved;
+	std::vector<float*> m_interleavedChannels;
+
+	// Auto timing, coefficients per detector channel and control period of a sub-block
+	TimeCoefficientTable m_timeCoefficients;
+	SampleBuffer<float> m_autoAttackCoef;
+	SampleBuffer<float> m_autoReleaseCoef;
+
+	// Weighted link gains per channel of the current layout
+	std::vector<float> m_linkWeights;
+
+	// Oversampling, the detector runs at m_sampleRate times the factor
+	int m_oversamplingStages = 0;
+	double m_sampleRate = 48000.0;
+	int m_blockSize = 0;
+
+	// Sample rate dependent state and latency for the given number of stages, does not allocate
+	void updateOversampling(int stages);
+
+	// Look-ahead in samples at the base rate, the delay lines run at the oversampled rate
+	int m_lookaheadSamples = 0;
+
+	// Look-ahead parameter in samples at the base rate
+	int getLookaheadSamples() const;
+
+	// Resets the delay lines and sliding maximums for the new length, does not allocate
+	void updateLookahead(int samples);
+
+	// RMS window in samples at the base rate, the running sums run at the oversampled rate
+	int m_rmsWindowSamples = 1;
+
+	// RMS window parameter in samples at the base rate
+	int getRmsWindowSamples() const;
+
+	// Ring size of the running sums for the longest window at the factor of parameters, 0 for Peak
+	int getRmsCapacity(const Parameters& parameters) const;
+
+	// Rings of the running sums for the current parameters, only the bands in use and the precision and lane
+	// path that reads them. Bands and paths without one get a single sample ring
+	template<typename SampleType>
+	void allocateRms(SampleState<SampleType>& state, int channels, bool lanes);
+
+	// Allocated ring size and bands of the running sums
+	int m_rmsCapacity = 0;
+	int m_rmsBands = 0;
+	bool m_maxRmsWindows = false;
+
+	// Resets the running sums for the new window, does not allocate
+	void updateRmsWindow(int samples);
+
+	// Detector of the last block, Peak leaves the running sums unfed
+	detector m_detection = Peak;
+
+	// Input and output loudness at the base rate, measured only while auto makeup is on
+	LoudnessMeter m_loudness;
+	bool m_autoMakeup = false;
+
+	// Auto makeup gain at the base rate, back to 0 dB once auto makeup is off
+	ParameterRamp<true> m_makeupRamp;
+
+	// Oversampling filters plus look-ahead
+	void updateLatency();
+	int m_latencySamples = 0;
+
+	// Manual attack and release coefficients, recomputed only when a time or the sample rate changes.
+	// Double holds either precision exactly
+	float m_cachedAttack = -1.0f;
+	float m_cachedRelease = -1.0f;
+	double m_attackCoef = 0.0;
+	double m_releaseCoef = 0.0;
+
+	// Per sample ramps of the gain related parameters, at the oversampled rate
+	ParameterRamp<false> m_thresholdRamp;
+	ParameterRamp<false> m_slopeRamp;
+	ParameterRamp<false> m_mixRamp;
+	ParameterRamp<true> m_volumeRamp;
+
+	// Band threshold offsets, 0 dB with a single band
+	ParameterRamp<false> m_bandThresholdRamps[MAX_BANDS];
+
+	enum rampChannel
+	{
+		ThresholdRamp = 0,
+		SlopeRamp,
+		MixRamp,
+		VolumeRamp,
+		BandThresholdRamp,
+		MakeupRamp,
+		RampChannels
+	};
+
+	SampleBuffer<float> m_ramps;
+
+	int m_gainCurveSamples = 0;
+	int m_gainCurveChannels = 0;
+
+	// Part of the pipeline a detector channel needs in the current sub-block
+	enum blockPath
+	{
+		FullPath = 0,
+		SilentDetectorInput,  // LogDomain below threshold, the gain computer would output 0 dB
+		UnityGain,            // ReturnToZero below threshold, the detector runs, the gain stays at 0 dB
+		IdlePath              // Silent and released, closed form detector, the gain stays at 0 dB
+	};
+
+	std::vector<blockPath> m_blockPath;
+
+	static blockPath getBlockPath(architecture architecture, double levelPeak, double envelopeLevel, float threshold);
+
+	// Largest output the detector of a band channel can reach on silence
+	template<typename SampleType>
+	double getEnvelopeLevel(int band, int channel, bool lanes);
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	struct alignas(CACHE_LINE_SIZE) LaneGroupState
+	{
+		EnvelopeFollowerLanes envelopeFollower;
+		RunningRmsLanes runningRms;
+	};
+
+	// Channels in groups of 4 lanes, the last group may be partial. Band major, band * m_laneGroups + group
+	std::vector<LaneGroupState> m_laneGroupState;
+	int m_laneGroups = 0;
+
+	// Input and output of lanes without a channel
+	std::vector<float> m_laneSilence;
+	std::vector<float> m_laneScratch;
+#endif
+
+	// Filled by process, pushed once per block while metering. The queues are allocated when first enabled
+	// and kept, the flag is stored after the pointer so the processing thread never sees it unset
+	MeterFrame m_meterFrame;
+	std::atomic<bool> m_metering{ false };
+	std::unique_ptr<MeterQueue<MeterFrame, 2048>> m_meterQueue;
+
+	std::atomic<bool> m_profiling{ false };
+	ProfileFrame m_profileFrame;
+	std::unique_ptr<MeterQueue<ProfileFrame, 1024>> m_profileQueue;
+	ProfileStats m_profileStats;
+};
@@ -0,0 +1,325 @@
+/*
+  ==============================================================================
+
+    C interface of CompressorEngine.
+
+  ==============================================================================
+*/
+
+#include <new>
+#include "CompressorEngineC.h"
+#include "CompressorEngine.h"
+#include "CompressorBank.h"
+
+struct CompressorHandle
+{
+	CompressorEngine engine;
+	CompressorEngine::Parameters parameters;
+	bool doublePrecision = false;
+
+	// Cleared while prepare runs, a failed prepare leaves the engine partly allocated
+	bool prepared = false;
+};
+
+struct CompressorBankHandle
+{
+	explicit CompressorBankHandle(int threads) : bank(threads) {}
+
+	CompressorBank bank;
+};
+
+namespace
+{
+	// Block of the prepared precision and layout
+	bool canProcess(const CompressorHandle* handle, int numChannels, bool doublePrecision)
+	{
+		return handle != nullptr && handle->prepared && handle->doublePrecision == doublePrecision
+			&& numChannels == handle->engine.getNumChannels();
+	}
+
+	// Up to the prepared sidechain channels
+	bool canKey(const CompressorHandle* handle, const void* key, int keyChannels)
+	{
+		return keyChannels >= 0 && keyChannels <= handle->engine.getNumKeyChannels() && (key != nullptr || keyChannels == 0);
+	}
+
+	// False for an unknown parameter
+	bool setParameter(CompressorEngine::Parameters& parameters, CompressorParameter parameter, float value)
+	{
+		switch (parameter)
+		{
+		case COMPRESSOR_ATTACK:       parameters.attack = value; break;
+		case COMPRESSOR_RELEASE:      parameters.release = value; break;
+		case COMPRESSOR_RATIO:        parameters.ratio = value; break;
+		case COMPRESSOR_THRESHOLD:    parameters.threshold = value; break;
+		case COMPRESSOR_MIX:          parameters.mix = value; break;
+		case COMPRESSOR_VOLUME:       parameters.volume = value; break;
+		case COMPRESSOR_LOOKAHEAD:    parameters.lookahead = value; break;
+		case COMPRESSOR_OVERSAMPLING: parameters.oversampling = (int)value; break;
+		case COMPRESSOR_BANDS:        parameters.bands = (int)value; break;
+		case COMPRESSOR_RMS_WINDOW:   parameters.rmsWindow = value; break;
+		case COMPRESSOR_SIDECHAIN:    parameters.sidechain = value >= 0.5f; break;
+		case COMPRESSOR_KEY_FREQUENCY: parameters.keyFrequency = value; break;
+		case COMPRESSOR_AUTO_MAKEUP:  parameters.autoMakeup = value >= 0.5f; break;
+
+		case COMPRESSOR_LINK:
+			parameters.link = (CompressorEngine::channelLink)(std::clamp((int)value, 0, 3) + 1);
+			break;
+
+		case COMPRESSOR_TIMING:
+			parameters.timing = (CompressorEngine::automation)(std::clamp((int)value, 0, 1) + 1);
+			break;
+
+		case COMPRESSOR_DETECTOR:
+			parameters.detection = (CompressorEngine::detector)(std::clamp((int)value, 0, 2) + 1);
+			break;
+
+		case COMPRESSOR_KEY_FILTER:
+			parameters.keyFilter = (CompressorEngine::keyFilterType)(std::clamp((int)value, 0, 2) + 1);
+			break;
+
+		case COMPRESSOR_MODE:
+			for (int band = 0; band < CompressorEngine::MAX_BANDS; ++band)
+				CompressorEngine::getMode(std::clamp((int)value, 0, CompressorEngine::MODES - 1), parameters.modes.architectures[band], parameters.modes.ballisticTypes[band]);
+			break;
+
+		default:
+			return false;
+		}
+
+		return true;
+	}
+}
+
+CompressorHandle* compressor_create(void)
+{
+	return new (std::nothrow) CompressorHandle();
+}
+
+void compressor_destroy(CompressorHandle* handle)
+{
+	delete handle;
+}
+
+int compressor_prepare(CompressorHandle* handle, double sampleRate, int maxBlockSize, int channels, int doublePrecision)
+{
+	return compressor_prepare_sidechain(handle, sampleRate, maxBlockSize, channels, 0, doublePrecision);
+}
+
+int compressor_prepare_sidechain(CompressorHandle* handle, double sampleRate, int maxBlockSize, int channels, int keyChannels, int doublePrecision)
+{
+	if (handle == nullptr || sampleRate <= 0.0 || maxBlockSize <= 0 || channels <= 0 || keyChannels < 0)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->prepared = false;
+
+	try
+	{
+		handle->doublePrecision = doublePrecision != 0;
+		handle->engine.setParameters(handle->parameters);
+		handle->engine.prepare(sampleRate, maxBlockSize, channels, handle->doublePrecision, keyChannels);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return COMPRESSOR_OUT_OF_MEMORY;
+	}
+
+	handle->prepared = true;
+	return COMPRESSOR_OK;
+}
+
+int compressor_reset(CompressorHandle* handle)
+{
+	if (handle == nullptr)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	if (! handle->prepared)
+		return COMPRESSOR_NOT_PREPARED;
+
+	handle->engine.reset();
+	return COMPRESSOR_OK;
+}
+
+int compressor_set_parameter(CompressorHandle* handle, CompressorParameter parameter, float value)
+{
+	if (handle == nullptr || ! setParameter(handle->parameters, parameter, value))
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.setParameters(handle->parameters);
+	return COMPRESSOR_OK;
+}
+
+int compressor_set_band(CompressorHandle* handle, int band, int mode, float threshold)
+{
+	if (handle == nullptr || band < 0 || band >= CompressorEngine::MAX_BANDS || mode < 0 || mode >= CompressorEngine::MODES)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	auto& parameters = handle->parameters;
+	CompressorEngine::getMode(mode, parameters.modes.architectures[band], parameters.modes.ballisticTypes[band]);
+	parameters.bandThresholds[band] = threshold;
+
+	handle->engine.setParameters(parameters);
+	return COMPRESSOR_OK;
+}
+
+int compressor_set_crossover(CompressorHandle* handle, int split, float frequency)
+{
+	if (handle == nullptr || split < 0 || split >= CompressorEngine::MAX_BANDS - 1)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->parameters.crossovers[split] = frequency;
+
+	handle->engine.setParameters(handle->parameters);
+	return COMPRESSOR_OK;
+}
+
+int compressor_set_link_weights(CompressorHandle* handle, const float* weights)
+{
+	if (handle == nullptr || weights == nullptr)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	if (! handle->prepared)
+		return COMPRESSOR_NOT_PREPARED;
+
+	handle->engine.setLinkWeights(weights);
+	return COMPRESSOR_OK;
+}
+
+int compressor_process(CompressorHandle* handle, float* const* channels, int numChannels, int samples)
+{
+	if (channels == nullptr || samples < 0 || ! canProcess(handle, numChannels, false))
+		return (handle != nullptr && ! handle->prepared) ? COMPRESSOR_NOT_PREPARED : COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.process(channels, numChannels, samples);
+	return COMPRESSOR_OK;
+}
+
+int compressor_process_double(CompressorHandle* handle, double* const* channels, int numChannels, int samples)
+{
+	if (channels == nullptr || samples < 0 || ! canProcess(handle, numChannels, true))
+		return (handle != nullptr && ! handle->prepared) ? COMPRESSOR_NOT_PREPARED : COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.process(channels, numChannels, samples);
+	return COMPRESSOR_OK;
+}
+
+int compressor_process_sidechain(CompressorHandle* handle, float* const* channels, int numChannels, const float* const* key, int keyChannels, int samples)
+{
+	if (channels == nullptr || samples < 0 || ! canProcess(handle, numChannels, false) || ! canKey(handle, key, keyChannels))
+		return (handle != nullptr && ! handle->prepared) ? COMPRESSOR_NOT_PREPARED : COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.process(channels, numChannels, samples, key, keyChannels);
+	return COMPRESSOR_OK;
+}
+
+int compressor_process_sidechain_double(CompressorHandle* handle, double* const* channels, int numChannels, const double* const* key, int keyChannels, int samples)
+{
+	if (channels == nullptr || samples < 0 || ! canProcess(handle, numChannels, true) || ! canKey(handle, key, keyChannels))
+		return (handle != nullptr && ! handle->prepared) ? COMPRESSOR_NOT_PREPARED : COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.process(channels, numChannels, samples, key, keyChannels);
+	return COMPRESSOR_OK;
+}
+
+int compressor_process_interleaved(CompressorHandle* handle, float* data, int samples)
+{
+	if (handle == nullptr || data == nullptr || samples < 0 || ! canProcess(handle, handle->engine.getNumChannels(), false))
+		return (handle != nullptr && ! handle->prepared) ? COMPRESSOR_NOT_PREPARED : COMPRESSOR_INVALID_ARGUMENT;
+
+	handle->engine.processInterleaved(data, samples);
+	return COMPRESSOR_OK;
+}
+
+int compressor_get_latency(const CompressorHandle* handle)
+{
+	return (handle != nullptr) ? handle->engine.getLatencySamples() : 0;
+}
+
+int compressor_needs_prepare(const CompressorHandle* handle)
+{
+	return (handle != nullptr && handle->engine.needsPrepare()) ? 1 : 0;
+}
+
+//==============================================================================
+CompressorBankHandle* compressor_bank_create(int threads)
+{
+	try
+	{
+		return new CompressorBankHandle(threads);
+	}
+	catch (const std::exception&)
+	{
+		// Out of memory or no threads
+		return nullptr;
+	}
+}
+
+void compressor_bank_destroy(CompressorBankHandle* bank)
+{
+	delete bank;
+}
+
+int compressor_bank_prepare(CompressorBankHandle* bank, int streams, double sampleRate, int maxBlockSize, int channels)
+{
+	if (bank == nullptr || streams < 0 || sampleRate <= 0.0 || maxBlockSize <= 0 || channels <= 0)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	try
+	{
+		bank->bank.prepare(streams, sampleRate, maxBlockSize, channels);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return COMPRESSOR_OUT_OF_MEMORY;
+	}
+
+	return COMPRESSOR_OK;
+}
+
+int compressor_bank_set_parameter(CompressorBankHandle* bank, int stream, CompressorParameter parameter, float value)
+{
+	if (bank == nullptr || stream < 0 || stream >= bank->bank.getNumStreams())
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	auto parameters = bank->bank.getParameters(stream);
+	if (! setParameter(parameters, parameter, value))
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	bank->bank.setParameters(stream, parameters);
+	return COMPRESSOR_OK;
+}
+
+int compressor_bank_reset(CompressorBankHandle* bank, int stream)
+{
+	if (bank == nullptr || stream < 0 || stream >= bank->bank.getNumStreams())
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	try
+	{
+		bank->bank.reset(stream);
+	}
+	catch (const std::bad_alloc&)
+	{
+		return COMPRESSOR_OUT_OF_MEMORY;
+	}
+
+	return COMPRESSOR_OK;
+}
+
+int compressor_bank_process(CompressorBankHandle* bank, float* const* const* buffers, int samples)
+{
+	if (bank == nullptr || buffers == nullptr || samples < 0)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	bank->bank.process(buffers, samples);
+	return COMPRESSOR_OK;
+}
+
+int compressor_bank_process_interleaved(CompressorBankHandle* bank, float* const* buffers, int samples)
+{
+	if (bank == nullptr || buffers == nullptr || samples < 0)
+		return COMPRESSOR_INVALID_ARGUMENT;
+
+	bank->bank.processInterleaved(buffers, samples);
+	return COMPRESSOR_OK;
+}
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    C interface of CompressorEngine, for services that embed the DSP without
+    C++ or JUCE, one stream per handle or many in a bank.
+
+    A handle is one engine for one stream. compressor_prepare allocates, the
+    other calls never do. Parameters, processing and the getters belong to
+    the processing thread, a handle is not shared between threads without
+    the caller's locking. Parameters are plain values in the ranges of the
+    plugin parameters, values outside are clamped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CompressorHandle CompressorHandle;
+typedef struct CompressorBankHandle CompressorBankHandle;
+
+enum
+{
+	COMPRESSOR_OK = 0,
+	COMPRESSOR_INVALID_ARGUMENT = -1,
+	COMPRESSOR_OUT_OF_MEMORY = -2,
+	COMPRESSOR_NOT_PREPARED = -3
+};
+
+typedef enum
+{
+	COMPRESSOR_ATTACK = 0,          // ms, 0.1 to 80
+	COMPRESSOR_RELEASE,             // ms, 1 to 200
+	COMPRESSOR_RATIO,               // 0.6 to 8
+	COMPRESSOR_THRESHOLD,           // dB, -60 to 12
+	COMPRESSOR_MIX,                 // 0 to 1
+	COMPRESSOR_VOLUME,              // dB, -24 to 24
+	COMPRESSOR_LOOKAHEAD,           // ms, 0 to 20
+	COMPRESSOR_MODE,                // 0-3, mode A-D of every band
+	COMPRESSOR_LINK,                // 0 Off, 1 Max, 2 Mean, 3 Weighted
+	COMPRESSOR_TIMING,              // 0 Manual, 1 Auto
+	COMPRESSOR_OVERSAMPLING,        // 2x stages, 0 to 3
+	COMPRESSOR_BANDS,               // 1 to 5
+	COMPRESSOR_DETECTOR,            // 0 Peak, 1 RMS, 2 Hybrid
+	COMPRESSOR_RMS_WINDOW,          // ms, 1 to 100
+	COMPRESSOR_SIDECHAIN,           // 0 Off, 1 the key of compressor_process_sidechain drives the detectors
+	COMPRESSOR_KEY_FILTER,          // 0 Off, 1 High pass, 2 Band pass
+	COMPRESSOR_KEY_FREQUENCY,       // Hz, 20 to 20000
+	COMPRESSOR_AUTO_MAKEUP          // 0 Off, 1 gain keeps the output loudness at the input loudness, VOLUME trims on top
+} CompressorParameter;
+
+// NULL when out of memory. Default parameters, mode A
+CompressorHandle* compressor_create(void);
+void compressor_destroy(CompressorHandle* handle);
+
+// Allocates for the layout and the largest block, resets all state. Only the given precision can be processed.
+// RMS windows are allocated for the current DETECTOR, OVERSAMPLING and BANDS, see compressor_needs_prepare
+int compressor_prepare(CompressorHandle* handle, double sampleRate, int maxBlockSize, int channels, int doublePrecision);
+
+// Same, with room for a sidechain of up to keyChannels channels
+int compressor_prepare_sidechain(CompressorHandle* handle, double sampleRate, int maxBlockSize, int channels, int keyChannels, int doublePrecision);
+
+// Clears filters, detectors and delays, keeps the parameters
+int compressor_reset(CompressorHandle* handle);
+
+int compressor_set_parameter(CompressorHandle* handle, CompressorParameter parameter, float value);
+
+// band 0-4, mode 0-3 (A-D), threshold offset in dB to the threshold, -24 to 24
+int compressor_set_band(CompressorHandle* handle, int band, int mode, float threshold);
+
+// split 0-3, frequency in Hz of the crossover above band split
+int compressor_set_crossover(CompressorHandle* handle, int split, float frequency);
+
+// Weighted link gains, one per prepared channel, normalized to unity sum
+int compressor_set_link_weights(CompressorHandle* handle, const float* weights);
+
+// In place, channels planar buffers of samples each, any length
+int compressor_process(CompressorHandle* handle, float* const* channels, int numChannels, int samples);
+int compressor_process_double(CompressorHandle* handle, double* const* channels, int numChannels, int samples);
+
+// Same, key holds keyChannels planar buffers of samples each, read in place. A key of numChannels channels
+// keys every channel, any other count is linked
+int compressor_process_sidechain(CompressorHandle* handle, float* const* channels, int numChannels, const float* const* key, int keyChannels, int samples);
+int compressor_process_sidechain_double(CompressorHandle* handle, double* const* channels, int numChannels, const double* const* key, int keyChannels, int samples);
+
+// In place, samples frames of the prepared channel count, float precision only
+int compressor_process_interleaved(CompressorHandle* handle, float* data, int samples);
+
+// Oversampling filters plus look-ahead in samples, updated by process
+int compressor_get_latency(const CompressorHandle* handle);
+
+// 1 when the parameters need longer RMS windows than compressor_prepare allocated, RMS or Hybrid after Peak,
+// a higher oversampling factor or more bands. The windows are shortened to what fits until the next prepare
+int compressor_needs_prepare(const CompressorHandle* handle);
+
+//==============================================================================
+// Bank of streams compressors of the same layout on a thread pool, see CompressorBank.h.
+// threads counts the calling thread, 0 uses the hardware threads. NULL when out of memory
+CompressorBankHandle* compressor_bank_create(int threads);
+void compressor_bank_destroy(CompressorBankHandle* bank);
+
+// Allocates every stream with default parameters, float precision
+int compressor_bank_prepare(CompressorBankHandle* bank, int streams, double sampleRate, int maxBlockSize, int channels);
+
+// Applied at the next process of the stream, not concurrent with process
+int compressor_bank_set_parameter(CompressorBankHandle* bank, int stream, CompressorParameter parameter, float value);
+
+// Clears the state of a stream for a new source, keeps its parameters. Allocates when they need longer RMS
+// windows than the stream had, see compressor_needs_prepare
+int compressor_bank_reset(CompressorBankHandle* bank, int stream);
+
+// In place, buffers[stream] holds the planar channels of a stream, samples each
+int compressor_bank_process(CompressorBankHandle* bank, float* const* const* buffers, int samples);
+
+// In place, buffers[stream] holds samples interleaved frames of a stream
+int compressor_bank_process_interleaved(CompressorBankHandle* bank, float* const* buffers, int samples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,252 @@
+/*
+  ==============================================================================
+
+    Linkwitz-Riley crossover, 2 to 5 bands.
+
+    Every split is a 4th order Linkwitz-Riley pair, two cascaded Butterworth
+    state variable filters (topology preserving transform, modulation safe).
+    Bands below a split pass its allpass, so the bands always sum to an
+    allpass of the input, flat magnitude.
+
+    Float runs 4 channels as FastMath::Vec4 lanes, double runs scalar.
+    State lives in one contiguous array per channel or lane group, allocated
+    in prepare, processing does not allocate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+
+//==============================================================================
+// Butterworth 2nd order state variable filter, Type is float, double or FastMath::Vec4
+template<typename Type>
+struct StateVariableFilter
+{
+	Type s1 = Type(0.0f);
+	Type s2 = Type(0.0f);
+
+	// Band pass out, low pass in lp. High pass is x - k * band - low, allpass x - 2k * band
+	inline Type process(Type x, Type a1, Type a2, Type a3, Type& lp)
+	{
+		const Type v3 = x - s2;
+		const Type v1 = a1 * s1 + a2 * v3;
+		const Type v2 = s2 + a2 * s1 + a3 * v3;
+
+		s1 = Type(2.0f) * v1 - s1;
+		s2 = Type(2.0f) * v2 - s2;
+
+		lp = v2;
+		return v1;
+	}
+};
+
+//==============================================================================
+template<typename SampleType>
+class Crossover
+{
+public:
+	static constexpr int MAX_BANDS = 5;
+	static constexpr int MAX_SPLITS = MAX_BANDS - 1;
+
+	// Butterworth damping, 1 / Q
+	static constexpr double K = 1.4142135623730951;
+
+	// Unused lanes of the last group write to scratch
+	void prepare(int channels, int maxSamples)
+	{
+		m_channels = channels;
+		m_state.assign((size_t)channels, State<SampleType>());
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (std::is_same<SampleType, float>::value)
+		{
+			m_laneState.assign((size_t)((channels + LANES - 1) / LANES), State<FastMath::Vec4>());
+			m_scratch.assign((size_t)maxSamples, 0.0f);
+		}
+#endif
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_state.begin(), m_state.end(), State<SampleType>());
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		std::fill(m_laneState.begin(), m_laneState.end(), State<FastMath::Vec4>());
+#endif
+	}
+
+	// frequencies holds bands - 1 ascending crossovers in Hz. The state is kept unless the band count changes
+	void setBands(int bands, const float* frequencies, double sampleRate)
+	{
+		bands = std::clamp(bands, 1, MAX_BANDS);
+
+		if (bands != m_bands)
+		{
+			m_bands = bands;
+			reset();
+		}
+
+		for (int split = 0; split < m_bands - 1; ++split)
+		{
+			const double frequency = std::clamp((double)frequencies[split], 10.0, 0.49 * sampleRate);
+			const double g = std::tan(FastMath::pi * frequency / sampleRate);
+
+			m_a1[split] = 1.0 / (1.0 + g * (g + K));
+			m_a2[split] = g * m_a1[split];
+			m_a3[split] = g * m_a2[split];
+		}
+	}
+
+	int getBands() const { return m_bands; }
+
+	// out[band * channels + channel], in is not changed
+	void process(const SampleType* const* in, SampleType* const* out, int channels, int samples)
+	{
+		int first = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (std::is_same<SampleType, float>::value)
+			first = processLanes(in, out, channels, samples);
+#endif
+
+		SampleType a1[MAX_SPLITS], a2[MAX_SPLITS], a3[MAX_SPLITS];
+		getCoefficients(a1, a2, a3);
+
+		for (int channel = first; channel < channels; ++channel)
+		{
+			auto& state = m_state[(size_t)channel];
+			SampleType bands[MAX_BANDS] = {};
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				split(in[channel][sample], bands, state, a1, a2, a3);
+
+				for (int band = 0; band < m_bands; ++band)
+					out[band * channels + channel][sample] = bands[band];
+			}
+		}
+	}
+
+private:
+	template<typename Type>
+	struct State
+	{
+		// Shared first stage, second low pass, second high pass
+		StateVariableFilter<Type> split[MAX_SPLITS][3];
+
+		// Allpass of a split for every band below it
+		StateVariableFilter<Type> allpass[MAX_SPLITS][MAX_SPLITS - 1];
+	};
+
+	template<typename Type>
+	void getCoefficients(Type* a1, Type* a2, Type* a3) const
+	{
+		for (int split = 0; split < m_bands - 1; ++split)
+		{
+			a1[split] = Type((SampleType)m_a1[split]);
+			a2[split] = Type((SampleType)m_a2[split]);
+			a3[split] = Type((SampleType)m_a3[split]);
+		}
+	}
+
+	// One sample through every split, lower bands first
+	template<typename Type>
+	inline void split(Type x, Type* bands, State<Type>& state, const Type* a1, const Type* a2, const Type* a3) const
+	{
+		const Type k = Type((SampleType)K);
+		const Type k2 = Type((SampleType)(2.0 * K));
+
+		Type rest = x;
+
+		for (int split = 0; split < m_bands - 1; ++split)
+		{
+			auto& filters = state.split[split];
+
+			Type lowFirst = rest;
+			const Type bandFirst = filters[0].process(rest, a1[split], a2[split], a3[split], lowFirst);
+			const Type highFirst = rest - k * bandFirst - lowFirst;
+
+			Type low = lowFirst;
+			filters[1].process(lowFirst, a1[split], a2[split], a3[split], low);
+
+			Type highLow = highFirst;
+			const Type highBand = filters[2].process(highFirst, a1[split], a2[split], a3[split], highLow);
+
+			for (int band = 0; band < split; ++band)
+			{
+				Type allpassLow = bands[band];
+				bands[band] = bands[band] - k2 * state.allpass[split][band].process(bands[band], a1[split], a2[split], a3[split], allpassLow);
+			}
+
+			bands[split] = low;
+			rest = highFirst - k * highBand - highLow;
+		}
+
+		bands[m_bands - 1] = rest;
+	}
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	static constexpr int LANES = 4;
+
+	// Channels in groups of 4, returns the channels done
+	int processLanes(const float* const* in, float* const* out, int channels, int samples)
+	{
+		using FastMath::Vec4;
+
+		Vec4 a1[MAX_SPLITS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		Vec4 a2[MAX_SPLITS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		Vec4 a3[MAX_SPLITS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		getCoefficients(a1, a2, a3);
+
+		for (int group = 0; group * LANES < channels; ++group)
+		{
+			const int first = group * LANES;
+			auto& state = m_laneState[(size_t)group];
+
+			// Unused lanes repeat the last channel and write to scratch
+			const float* inputs[LANES];
+			float* outputs[MAX_BANDS][LANES];
+
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				const int channel = first + lane;
+				inputs[lane] = in[std::min(channel, channels - 1)];
+
+				for (int band = 0; band < m_bands; ++band)
+					outputs[band][lane] = (channel < channels) ? out[band * channels + channel] : m_scratch.data();
+			}
+
+			Vec4 bands[MAX_BANDS] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+			for (int sample = 0; sample < samples; ++sample)
+			{
+				split(Vec4::gather(inputs, sample), bands, state, a1, a2, a3);
+
+				for (int band = 0; band < m_bands; ++band)
+					bands[band].scatter(outputs[band], sample);
+			}
+		}
+
+		return channels;
+	}
+
+	std::vector<State<FastMath::Vec4>> m_laneState;
+	std::vector<float> m_scratch;
+#endif
+
+	int m_channels = 0;
+	int m_bands = 1;
+
+	double m_a1[MAX_SPLITS] = {};
+	double m_a2[MAX_SPLITS] = {};
+	double m_a3[MAX_SPLITS] = {};
+
+	std::vector<State<SampleType>> m_state;
+};
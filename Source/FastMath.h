@@ -0,0 +1,375 @@
+/*
+  ==============================================================================
+
+    Fast log2 / exp2 approximations used by the gain computer.
+
+    Mantissa / exponent split with polynomial correction. Scalar functions are
+    branch free, array functions run 4 lanes at a time with SSE2 or NEON and
+    fall back to the scalar code elsewhere. Vec4 is also used by the
+    multichannel envelope kernels.
+
+    Double overloads use the exact library functions, they serve the double
+    precision path and are not vectorized.
+
+    Maximum error against juce::Decibels, full float range:
+
+    Accuracy    gainToDecibels    decibelsToGain
+    Fast        0.016 dB          0.020 dB
+    Balanced    0.0022 dB         0.0009 dB
+    Precise     0.00005 dB        0.00001 dB
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define FASTMATH_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define FASTMATH_NEON 1
+#endif
+
+#ifndef COMPRESSOR_DB_ACCURACY
+ #define COMPRESSOR_DB_ACCURACY Balanced
+#endif
+
+namespace FastMath
+{
+	enum class Accuracy
+	{
+		Fast = 1,
+		Balanced,
+		Precise
+	};
+
+	// Used by the gain computer, override with COMPRESSOR_DB_ACCURACY=Fast|Balanced|Precise
+	constexpr Accuracy defaultAccuracy = Accuracy::COMPRESSOR_DB_ACCURACY;
+
+	// Same floor as juce::Decibels
+	constexpr float minusInfinityDb = -100.0f;
+
+	constexpr double pi = 3.14159265358979323846;
+
+	// Smallest positive normal float
+	constexpr float minNormal = 1.17549435e-38f;
+
+	// 20 * log10(2) and log2(10) / 20
+	constexpr float log2ToDecibels = 6.02059991f;
+	constexpr float decibelsToLog2 = 0.166096404f;
+
+	//==============================================================================
+	inline float asFloat(int32_t bits)
+	{
+		float x;
+		std::memcpy(&x, &bits, sizeof(x));
+		return x;
+	}
+
+	inline int32_t asInt(float x)
+	{
+		int32_t bits;
+		std::memcpy(&bits, &x, sizeof(bits));
+		return bits;
+	}
+
+	inline float max(float a, float b) { return (a > b) ? a : b; }
+	inline float min(float a, float b) { return (a < b) ? a : b; }
+	inline float abs(float a) { return asFloat(asInt(a) & 0x7fffffff); }
+	inline float selectGreater(float a, float b, float x, float y) { return (a > b) ? x : y; }
+
+	inline double max(double a, double b) { return (a > b) ? a : b; }
+	inline double min(double a, double b) { return (a < b) ? a : b; }
+	inline double abs(double a) { return std::fabs(a); }
+	inline double selectGreater(double a, double b, double x, double y) { return (a > b) ? x : y; }
+
+	//==============================================================================
+	// log2(1 + t) = t * P(t), t in [0, 1). Type is float or Vec4
+	template<Accuracy accuracy, typename Type>
+	inline Type log2Polynomial(Type t)
+	{
+		if (accuracy == Accuracy::Fast)
+			return Type(1.4382303f) + t * (Type(-0.637541398f) + t * Type(0.201861586f));
+		else if (accuracy == Accuracy::Balanced)
+			return Type(1.442068f) + t * (Type(-0.700778105f) + t * (Type(0.364018767f) + t * Type(-0.105659241f)));
+		else
+			return Type(1.44268147f) + t * (Type(-0.720358773f) + t * (Type(0.468658879f) + t * (Type(-0.30163801f) + t * (Type(0.144471096f) + t * Type(-0.033822046f)))));
+	}
+
+	// 2^f = P(f), f in [0, 1]
+	template<Accuracy accuracy, typename Type>
+	inline Type exp2Polynomial(Type f)
+	{
+		if (accuracy == Accuracy::Fast)
+			return Type(1.00226481f) + f * (Type(0.652752681f) + f * Type(0.342289647f));
+		else if (accuracy == Accuracy::Balanced)
+			return Type(0.999900288f) + f * (Type(0.696324771f) + f * (Type(0.224693156f) + f * Type(0.078967257f)));
+		else
+			return Type(0.999999898f) + f * (Type(0.69315449f) + f * (Type(0.240141818f) + f * (Type(0.0558603371f) + f * (Type(0.00894959042f) + f * Type(0.00189375406f)))));
+	}
+
+	//==============================================================================
+	// log2(x) for positive normal x
+	template<Accuracy accuracy = defaultAccuracy>
+	inline float log2(float x)
+	{
+		const int32_t bits = asInt(x);
+		const float exponent = (float)(((bits >> 23) & 0xff) - 127);
+		const float t = asFloat((bits & 0x007fffff) | 0x3f800000) - 1.0f;
+
+		return exponent + t * log2Polynomial<accuracy>(t);
+	}
+
+	// 2^x, x clamped to the normal float range
+	template<Accuracy accuracy = defaultAccuracy>
+	inline float exp2(float x)
+	{
+		x = min(max(x, -126.0f), 127.0f);
+
+		// Round x - 0.5 to an integer by shifting it into the low mantissa bits of 1.5 * 2^23
+		const float shifted = (x - 0.5f) + 12582912.0f;
+		const int32_t exponent = asInt(shifted) - 0x4b400000;
+		const float f = x - (shifted - 12582912.0f);
+
+		return exp2Polynomial<accuracy>(f) * asFloat((exponent + 127) << 23);
+	}
+
+	//==============================================================================
+	// Drop-in replacements for juce::Decibels::gainToDecibels / decibelsToGain
+	template<Accuracy accuracy = defaultAccuracy>
+	inline float gainToDecibels(float gain)
+	{
+		// Zero and negative gains end up below the floor
+		return max(log2ToDecibels * log2<accuracy>(max(gain, minNormal)), minusInfinityDb);
+	}
+
+	template<Accuracy accuracy = defaultAccuracy>
+	inline float decibelsToGain(float dB)
+	{
+		const float gain = exp2<accuracy>(decibelsToLog2 * dB);
+		return (dB > minusInfinityDb) ? gain : 0.0f;
+	}
+
+	template<Accuracy accuracy = defaultAccuracy>
+	inline double gainToDecibels(double gain)
+	{
+		return max(20.0 * std::log10(max(gain, (double)minNormal)), (double)minusInfinityDb);
+	}
+
+	template<Accuracy accuracy = defaultAccuracy>
+	inline double decibelsToGain(double dB)
+	{
+		return (dB > minusInfinityDb) ? std::pow(10.0, dB * 0.05) : 0.0;
+	}
+
+	//==============================================================================
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	// 4 float lanes, just enough operations for the conversions, envelope and RMS kernels
+	struct Vec4
+	{
+	#if FASTMATH_SSE2
+		using Native = __m128;
+		Vec4(Native v) : value(v) {}
+		Vec4(float x) : value(_mm_set1_ps(x)) {}
+		static Vec4 load(const float* p) { return _mm_loadu_ps(p); }
+		void store(float* p) const { _mm_storeu_ps(p, value); }
+		friend Vec4 operator+ (Vec4 a, Vec4 b) { return _mm_add_ps(a.value, b.value); }
+		friend Vec4 operator- (Vec4 a, Vec4 b) { return _mm_sub_ps(a.value, b.value); }
+		friend Vec4 operator* (Vec4 a, Vec4 b) { return _mm_mul_ps(a.value, b.value); }
+		friend Vec4 max(Vec4 a, Vec4 b) { return _mm_max_ps(a.value, b.value); }
+		friend Vec4 min(Vec4 a, Vec4 b) { return _mm_min_ps(a.value, b.value); }
+		friend Vec4 sqrt(Vec4 a) { return _mm_sqrt_ps(a.value); }
+		// Lanes where a > b keep x, others are zero
+		friend Vec4 selectGreater(Vec4 a, Vec4 b, Vec4 x) { return _mm_and_ps(_mm_cmpgt_ps(a.value, b.value), x.value); }
+		// Lanes where a > b take x, others y
+		friend Vec4 selectGreater(Vec4 a, Vec4 b, Vec4 x, Vec4 y) { const __m128 mask = _mm_cmpgt_ps(a.value, b.value); return _mm_or_ps(_mm_and_ps(mask, x.value), _mm_andnot_ps(mask, y.value)); }
+		// (bits & andMask) | orMask
+		Vec4 maskBits(int32_t andMask, int32_t orMask) const { return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(_mm_castps_si128(value), _mm_set1_epi32(andMask)), _mm_set1_epi32(orMask))); }
+		// Unbiased exponent of positive lanes
+		Vec4 exponent() const { return _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(value), 23), _mm_set1_epi32(127))); }
+		// 2^n, n held in the low mantissa bits of 1.5 * 2^23 + n
+		Vec4 shiftedToPower() const { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_castps_si128(value), _mm_set1_epi32(0x4b400000)), _mm_set1_epi32(127)), 23)); }
+		// Lane i from / to p[i][index], built in registers to avoid store forwarding stalls
+		static Vec4 gather(const float* const* p, int index) { return _mm_setr_ps(p[0][index], p[1][index], p[2][index], p[3][index]); }
+		void scatter(float* const* p, int index) const
+		{
+			p[0][index] = _mm_cvtss_f32(value);
+			p[1][index] = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1)));
+			p[2][index] = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 2, 2, 2)));
+			p[3][index] = _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+	#else
+		using Native = float32x4_t;
+		Vec4(Native v) : value(v) {}
+		Vec4(float x) : value(vdupq_n_f32(x)) {}
+		static Vec4 load(const float* p) { return vld1q_f32(p); }
+		void store(float* p) const { vst1q_f32(p, value); }
+		friend Vec4 operator+ (Vec4 a, Vec4 b) { return vaddq_f32(a.value, b.value); }
+		friend Vec4 operator- (Vec4 a, Vec4 b) { return vsubq_f32(a.value, b.value); }
+		friend Vec4 operator* (Vec4 a, Vec4 b) { return vmulq_f32(a.value, b.value); }
+		friend Vec4 max(Vec4 a, Vec4 b) { return vmaxq_f32(a.value, b.value); }
+		friend Vec4 min(Vec4 a, Vec4 b) { return vminq_f32(a.value, b.value); }
+	#if defined(__aarch64__) || defined(_M_ARM64)
+		friend Vec4 sqrt(Vec4 a) { return vsqrtq_f32(a.value); }
+	#else
+		// Reciprocal estimate with two Newton steps, zero lanes stay zero
+		friend Vec4 sqrt(Vec4 a)
+		{
+			float32x4_t inverse = vrsqrteq_f32(a.value);
+			inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(a.value, inverse), inverse));
+			inverse = vmulq_f32(inverse, vrsqrtsq_f32(vmulq_f32(a.value, inverse), inverse));
+			return selectGreater(a, Vec4(0.0f), vmulq_f32(a.value, inverse));
+		}
+	#endif
+		friend Vec4 selectGreater(Vec4 a, Vec4 b, Vec4 x) { return vreinterpretq_f32_u32(vandq_u32(vcgtq_f32(a.value, b.value), vreinterpretq_u32_f32(x.value))); }
+		friend Vec4 selectGreater(Vec4 a, Vec4 b, Vec4 x, Vec4 y) { return vbslq_f32(vcgtq_f32(a.value, b.value), x.value, y.value); }
+		Vec4 maskBits(int32_t andMask, int32_t orMask) const { return vreinterpretq_f32_s32(vorrq_s32(vandq_s32(vreinterpretq_s32_f32(value), vdupq_n_s32(andMask)), vdupq_n_s32(orMask))); }
+		Vec4 exponent() const { return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_f32(value), 23)), vdupq_n_s32(127))); }
+		Vec4 shiftedToPower() const { return vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(vsubq_s32(vreinterpretq_s32_f32(value), vdupq_n_s32(0x4b400000)), vdupq_n_s32(127)), 23)); }
+		static Vec4 gather(const float* const* p, int index) { return vsetq_lane_f32(p[3][index], vsetq_lane_f32(p[2][index], vsetq_lane_f32(p[1][index], vdupq_n_f32(p[0][index]), 1), 2), 3); }
+		void scatter(float* const* p, int index) const
+		{
+			p[0][index] = vgetq_lane_f32(value, 0);
+			p[1][index] = vgetq_lane_f32(value, 1);
+			p[2][index] = vgetq_lane_f32(value, 2);
+			p[3][index] = vgetq_lane_f32(value, 3);
+		}
+	#endif
+
+		friend Vec4 abs(Vec4 a) { return a.maskBits(0x7fffffff, 0); }
+
+		Native value;
+	};
+
+	template<Accuracy accuracy = defaultAccuracy>
+	inline Vec4 gainToDecibels(Vec4 gain)
+	{
+		const Vec4 x = max(gain, Vec4(minNormal));
+		const Vec4 t = x.maskBits(0x007fffff, 0x3f800000) - Vec4(1.0f);
+		const Vec4 log2 = x.exponent() + t * log2Polynomial<accuracy>(t);
+
+		return max(Vec4(log2ToDecibels) * log2, Vec4(minusInfinityDb));
+	}
+
+	template<Accuracy accuracy = defaultAccuracy>
+	inline Vec4 decibelsToGain(Vec4 dB)
+	{
+		const Vec4 x = min(max(Vec4(decibelsToLog2) * dB, Vec4(-126.0f)), Vec4(127.0f));
+		const Vec4 shifted = (x - Vec4(0.5f)) + Vec4(12582912.0f);
+		const Vec4 f = x - (shifted - Vec4(12582912.0f));
+
+		return selectGreater(dB, Vec4(minusInfinityDb), exp2Polynomial<accuracy>(f) * shifted.shiftedToPower());
+	}
+#endif
+
+	//==============================================================================
+	// True when every buffer of a transform holds floats, only those run as Vec4
+	template<typename... Types>
+	constexpr bool allFloat = (std::is_same<Types, float>::value && ...);
+
+	// out[i] = function(in[i]), function is a generic lambda called with Vec4 and float,
+	// or with the scalar types of the buffers. in and out may be the same buffer
+	template<typename In, typename Out, typename Function>
+	inline void transform(const In* in, Out* out, int samples, Function function)
+	{
+		int sample = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (allFloat<In, Out>)
+			for (; sample + 4 <= samples; sample += 4)
+				function(Vec4::load(in + sample)).store(out + sample);
+#endif
+
+		for (; sample < samples; ++sample)
+			out[sample] = function(in[sample]);
+	}
+
+	// out[i] = function(a[i], b[i])
+	template<typename A, typename B, typename Out, typename Function>
+	inline void transform(const A* a, const B* b, Out* out, int samples, Function function)
+	{
+		int sample = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (allFloat<A, B, Out>)
+			for (; sample + 4 <= samples; sample += 4)
+				function(Vec4::load(a + sample), Vec4::load(b + sample)).store(out + sample);
+#endif
+
+		for (; sample < samples; ++sample)
+			out[sample] = function(a[sample], b[sample]);
+	}
+
+	// out[i] = function(a[i], b[i], c[i])
+	template<typename A, typename B, typename C, typename Out, typename Function>
+	inline void transform(const A* a, const B* b, const C* c, Out* out, int samples, Function function)
+	{
+		int sample = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (allFloat<A, B, C, Out>)
+			for (; sample + 4 <= samples; sample += 4)
+				function(Vec4::load(a + sample), Vec4::load(b + sample), Vec4::load(c + sample)).store(out + sample);
+#endif
+
+		for (; sample < samples; ++sample)
+			out[sample] = function(a[sample], b[sample], c[sample]);
+	}
+
+	template<Accuracy accuracy = defaultAccuracy, typename Type>
+	inline void gainToDecibels(const Type* in, Type* out, int samples)
+	{
+		transform(in, out, samples, [](auto gain) { return gainToDecibels<accuracy>(gain); });
+	}
+
+	template<Accuracy accuracy = defaultAccuracy, typename Type>
+	inline void decibelsToGain(const Type* in, Type* out, int samples)
+	{
+		transform(in, out, samples, [](auto dB) { return decibelsToGain<accuracy>(dB); });
+	}
+
+	// Largest absolute value, 0 for no samples
+	template<typename Type>
+	inline Type peak(const Type* in, int samples)
+	{
+		int sample = 0;
+		Type result = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (allFloat<Type>)
+		{
+			Vec4 lanes(0.0f);
+			for (; sample + 4 <= samples; sample += 4)
+				lanes = max(lanes, abs(Vec4::load(in + sample)));
+
+			float values[4];
+			lanes.store(values);
+			result = max(max(values[0], values[1]), max(values[2], values[3]));
+		}
+#endif
+
+		for (; sample < samples; ++sample)
+			result = max(result, abs(in[sample]));
+
+		return result;
+	}
+
+	// x^n by squaring, n >= 0
+	template<typename Type>
+	inline Type powInt(Type x, int n)
+	{
+		Type result = 1;
+
+		for (; n > 0; n >>= 1, x *= x)
+			if (n & 1)
+				result *= x;
+
+		return result;
+	}
+}
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    Gain reduction history and transfer curve of the editor.
+
+  ==============================================================================
+*/
+
+#include "GainReductionDisplay.h"
+
+//==============================================================================
+GainReductionHistory::GainReductionHistory()
+{
+	setOpaque(true);
+}
+
+void GainReductionHistory::push(float gainReductiondB)
+{
+	if (! m_image.isValid())
+		return;
+
+	const int width = m_image.getWidth();
+
+	m_image.moveImageSection(0, 0, COLUMN_WIDTH, 0, width - COLUMN_WIDTH, m_image.getHeight());
+
+	juce::Graphics g(m_image);
+	drawColumn(g, width - COLUMN_WIDTH, gainReductiondB);
+
+	repaint();
+}
+
+void GainReductionHistory::paint(juce::Graphics& g)
+{
+	g.drawImageAt(m_image, 0, 0);
+}
+
+void GainReductionHistory::resized()
+{
+	if (getWidth() <= COLUMN_WIDTH || getHeight() <= 0)
+	{
+		m_image = juce::Image();
+		return;
+	}
+
+	// History starts empty at the new size
+	m_image = juce::Image(juce::Image::RGB, getWidth(), getHeight(), false);
+	juce::Graphics g(m_image);
+
+	for (int x = 0; x < getWidth(); x += COLUMN_WIDTH)
+		drawColumn(g, x, 0.0f);
+}
+
+void GainReductionHistory::drawColumn(juce::Graphics& g, int x, float gainReductiondB)
+{
+	const int height = m_image.getHeight();
+
+	g.setColour(findColour(juce::Slider::rotarySliderOutlineColourId));
+	g.fillRect(x, 0, COLUMN_WIDTH, height);
+
+	// Gain reduction hangs from the top, 0 dB
+	const float reduction = juce::jlimit(0.0f, RANGE_DB, gainReductiondB);
+	g.setColour(findColour(juce::Slider::thumbColourId));
+	g.fillRect(x, 0, COLUMN_WIDTH, juce::roundToInt(reduction / RANGE_DB * height));
+
+	g.setColour(findColour(juce::Slider::rotarySliderFillColourId));
+	for (float dB = GRID_DB; dB < RANGE_DB; dB += GRID_DB)
+		g.fillRect(x, juce::roundToInt(dB / RANGE_DB * height), COLUMN_WIDTH, 1);
+}
+
+//==============================================================================
+TransferCurve::TransferCurve()
+{
+	setOpaque(true);
+}
+
+void TransferCurve::setCurve(float threshold, float ratio, float mix, float volume)
+{
+	if (threshold == m_threshold && ratio == m_ratio && mix == m_mix && volume == m_volume)
+		return;
+
+	m_threshold = threshold;
+	m_ratio = ratio;
+	m_mix = mix;
+	m_volume = volume;
+
+	renderCurve();
+	repaint();
+}
+
+void TransferCurve::setMakeup(float makeupdB)
+{
+	// The makeup glides, steps keep the rebuilds rare
+	const float makeup = (float)juce::roundToInt(makeupdB / MAKEUP_STEP_DB) * MAKEUP_STEP_DB;
+
+	if (makeup == m_makeup)
+		return;
+
+	m_makeup = makeup;
+
+	renderCurve();
+	repaint();
+}
+
+void TransferCurve::setLevel(float inputdB)
+{
+	const juce::Rectangle<int> previous = getDotBounds();
+	m_level = inputdB;
+	const juce::Rectangle<int> current = getDotBounds();
+
+	if (current == previous)
+		return;
+
+	repaint(previous);
+	repaint(current);
+}
+
+void TransferCurve::paint(juce::Graphics& g)
+{
+	g.drawImageAt(m_image, 0, 0);
+
+	const juce::Rectangle<int> dot = getDotBounds();
+
+	if (! dot.isEmpty())
+	{
+		g.setColour(juce::Colours::white);
+		g.fillEllipse(dot.reduced(1).toFloat());
+	}
+}
+
+void TransferCurve::resized()
+{
+	renderCurve();
+}
+
+float TransferCurve::getOutput(float inputdB) const
+{
+	// Same static curve as CompressorEngine::gainComputer, then Mix with the dry signal, the auto makeup and Volume
+	const float gaindB = (inputdB > m_threshold) ? (inputdB - m_threshold) * (1.0f / m_ratio - 1.0f) : 0.0f;
+	const float gain = m_mix * juce::Decibels::decibelsToGain(gaindB) + (1.0f - m_mix);
+
+	return inputdB + juce::Decibels::gainToDecibels(gain) + m_makeup + m_volume;
+}
+
+juce::Point<float> TransferCurve::toPosition(float inputdB, float outputdB) const
+{
+	const float x = (inputdB - MIN_DB) / (MAX_DB - MIN_DB) * (float)getWidth();
+	const float y = (MAX_DB - outputdB) / (MAX_DB - MIN_DB) * (float)getHeight();
+
+	return { x, y };
+}
+
+juce::Rectangle<int> TransferCurve::getDotBounds() const
+{
+	if (m_level <= MIN_DB || m_level > MAX_DB)
+		return {};
+
+	const juce::Point<float> position = toPosition(m_level, getOutput(m_level));
+
+	// One pixel around the dot for antialiasing
+	return juce::Rectangle<int>(DOT_SIZE + 2, DOT_SIZE + 2).withCentre(position.roundToInt());
+}
+
+void TransferCurve::renderCurve()
+{
+	if (getWidth() <= 0 || getHeight() <= 0)
+	{
+		m_image = juce::Image();
+		return;
+	}
+
+	m_image = juce::Image(juce::Image::RGB, getWidth(), getHeight(), false);
+	juce::Graphics g(m_image);
+
+	g.fillAll(findColour(juce::Slider::rotarySliderOutlineColourId));
+
+	// Grid and unity line
+	g.setColour(findColour(juce::Slider::rotarySliderFillColourId));
+
+	for (float dB = MIN_DB + GRID_DB; dB < MAX_DB; dB += GRID_DB)
+	{
+		const juce::Point<float> position = toPosition(dB, dB);
+		g.drawHorizontalLine(juce::roundToInt(position.y), 0.0f, (float)getWidth());
+		g.drawVerticalLine(juce::roundToInt(position.x), 0.0f, (float)getHeight());
+	}
+
+	g.drawLine(juce::Line<float>(toPosition(MIN_DB, MIN_DB), toPosition(MAX_DB, MAX_DB)));
+
+	// Curve, one point per pixel column
+	juce::Path curve;
+
+	for (int x = 0; x <= getWidth(); ++x)
+	{
+		const float inputdB = MIN_DB + (MAX_DB - MIN_DB) * (float)x / (float)getWidth();
+		const juce::Point<float> position = toPosition(inputdB, getOutput(inputdB));
+
+		if (x == 0)
+			curve.startNewSubPath(position);
+		else
+			curve.lineTo(position);
+	}
+
+	g.setColour(findColour(juce::Slider::thumbColourId));
+	g.strokePath(curve, juce::PathStrokeType(2.0f));
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    Gain reduction history and transfer curve of the editor.
+
+    Both keep what they draw in an image and only touch it when their
+    input changes. The history scrolls its image by one column per frame
+    and draws just the new column, the curve is rebuilt only when the
+    parameters move, the level dot repaints its own small rectangle. The
+    editor feeds them from its timer with meter frames and raw parameter
+    values, no locks are shared with the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Scrolling gain reduction, newest on the right, one column per frame
+class GainReductionHistory : public juce::Component
+{
+public:
+	static const int COLUMN_WIDTH = 2;
+	static constexpr float RANGE_DB = 24.0f;
+	static constexpr float GRID_DB = 6.0f;
+
+	GainReductionHistory();
+
+	// Positive dB, scrolls the history by one column
+	void push(float gainReductiondB);
+
+	void paint(juce::Graphics&) override;
+	void resized() override;
+
+private:
+	juce::Image m_image;
+
+	void drawColumn(juce::Graphics& g, int x, float gainReductiondB);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GainReductionHistory)
+};
+
+//==============================================================================
+// Static input to output curve with the current input level on it
+class TransferCurve : public juce::Component
+{
+public:
+	static constexpr float MIN_DB = -60.0f;
+	static constexpr float MAX_DB = 12.0f;
+	static constexpr float GRID_DB = 12.0f;
+	static const int DOT_SIZE = 6;
+	static constexpr float MAKEUP_STEP_DB = 0.1f;
+
+	TransferCurve();
+
+	// Rebuilds the curve only when a value changed
+	void setCurve(float threshold, float ratio, float mix, float volume);
+
+	// Auto makeup gain in dB under the volume, 0 while it is off. Rebuilds only on a step of MAKEUP_STEP_DB
+	void setMakeup(float makeupdB);
+
+	// Input peak in dB, repaints the old and new dot only
+	void setLevel(float inputdB);
+
+	void paint(juce::Graphics&) override;
+	void resized() override;
+
+private:
+	juce::Image m_image;
+
+	float m_threshold = 0.0f;
+	float m_ratio = 1.0f;
+	float m_mix = 1.0f;
+	float m_volume = 0.0f;
+	float m_makeup = 0.0f;
+	float m_level = MIN_DB;
+
+	// Output in dB of an input in dB, the gain computer of the engine with mix, makeup and volume
+	float getOutput(float inputdB) const;
+
+	juce::Point<float> toPosition(float inputdB, float outputdB) const;
+	juce::Rectangle<int> getDotBounds() const;
+
+	void renderCurve();
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TransferCurve)
+};
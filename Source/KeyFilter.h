@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    High pass or band pass filter of the detector key.
+
+    One state variable filter per channel, the filter of the crossover
+    (topology preserving transform, modulation safe). High pass is 2nd
+    order Butterworth, band pass has unity gain at its centre and a Q of
+    BAND_PASS_Q, about 2/3 of an octave wide.
+
+    Float runs 4 channels as FastMath::Vec4 lanes, double runs scalar.
+    State is allocated in prepare, processing does not allocate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+#include "Crossover.h"
+
+//==============================================================================
+template<typename SampleType>
+class KeyFilter
+{
+public:
+	static constexpr double BAND_PASS_Q = 2.0;
+
+	// Unused lanes of the last group write to scratch
+	void prepare(int channels, int maxSamples)
+	{
+		m_state.assign((size_t)channels, StateVariableFilter<SampleType>());
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (std::is_same<SampleType, float>::value)
+		{
+			m_laneState.assign((size_t)((channels + LANES - 1) / LANES), StateVariableFilter<FastMath::Vec4>());
+			m_scratch.assign((size_t)maxSamples, 0.0f);
+		}
+#endif
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_state.begin(), m_state.end(), StateVariableFilter<SampleType>());
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		std::fill(m_laneState.begin(), m_laneState.end(), StateVariableFilter<FastMath::Vec4>());
+#endif
+	}
+
+	// The state is kept unless the response changes
+	void setFilter(bool bandPass, float frequency, double sampleRate)
+	{
+		if (bandPass != m_bandPass)
+		{
+			m_bandPass = bandPass;
+			reset();
+		}
+
+		const double clamped = std::clamp((double)frequency, 10.0, 0.49 * sampleRate);
+		const double g = std::tan(FastMath::pi * clamped / sampleRate);
+
+		m_k = bandPass ? 1.0 / BAND_PASS_Q : Crossover<double>::K;
+		m_a1 = 1.0 / (1.0 + g * (g + m_k));
+		m_a2 = g * m_a1;
+		m_a3 = g * m_a2;
+	}
+
+	// In and out may be the same buffers
+	void process(const SampleType* const* in, SampleType* const* out, int channels, int samples)
+	{
+		int first = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (std::is_same<SampleType, float>::value)
+			first = processLanes(in, out, channels, samples);
+#endif
+
+		const SampleType a1 = (SampleType)m_a1;
+		const SampleType a2 = (SampleType)m_a2;
+		const SampleType a3 = (SampleType)m_a3;
+		const SampleType k = (SampleType)m_k;
+
+		for (int channel = first; channel < channels; ++channel)
+		{
+			auto& state = m_state[(size_t)channel];
+
+			for (int sample = 0; sample < samples; ++sample)
+				out[channel][sample] = filter(in[channel][sample], state, a1, a2, a3, k);
+		}
+	}
+
+private:
+	template<typename Type>
+	inline Type filter(Type x, StateVariableFilter<Type>& state, Type a1, Type a2, Type a3, Type k) const
+	{
+		Type low = x;
+		const Type band = state.process(x, a1, a2, a3, low);
+
+		return m_bandPass ? k * band : x - k * band - low;
+	}
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	static constexpr int LANES = 4;
+
+	// Channels in groups of 4, returns the channels done
+	int processLanes(const float* const* in, float* const* out, int channels, int samples)
+	{
+		using FastMath::Vec4;
+
+		const Vec4 a1 = (float)m_a1;
+		const Vec4 a2 = (float)m_a2;
+		const Vec4 a3 = (float)m_a3;
+		const Vec4 k = (float)m_k;
+
+		for (int group = 0; group * LANES < channels; ++group)
+		{
+			const int first = group * LANES;
+			auto& state = m_laneState[(size_t)group];
+
+			// Unused lanes repeat the last channel and write to scratch
+			const float* inputs[LANES];
+			float* outputs[LANES];
+
+			for (int lane = 0; lane < LANES; ++lane)
+			{
+				const int channel = first + lane;
+				inputs[lane] = in[std::min(channel, channels - 1)];
+				outputs[lane] = (channel < channels) ? out[channel] : m_scratch.data();
+			}
+
+			for (int sample = 0; sample < samples; ++sample)
+				filter(Vec4::gather(inputs, sample), state, a1, a2, a3, k).scatter(outputs, sample);
+		}
+
+		return channels;
+	}
+
+	std::vector<StateVariableFilter<FastMath::Vec4>> m_laneState;
+	std::vector<float> m_scratch;
+#endif
+
+	bool m_bandPass = false;
+
+	double m_k = Crossover<double>::K;
+	double m_a1 = 0.0;
+	double m_a2 = 0.0;
+	double m_a3 = 0.0;
+
+	std::vector<StateVariableFilter<SampleType>> m_state;
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    Look-ahead, the audio is delayed and the detector sees the peak of the
+    window the delayed audio is about to enter.
+
+    DelayLine is a preallocated ring buffer, SlidingMaximum keeps a monotonic
+    deque of candidate peaks, so every sample costs O(1) amortized whatever
+    the window length. Both are allocated in init, processing does not
+    allocate. SampleType is float or double.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+//==============================================================================
+template<typename SampleType>
+class DelayLine
+{
+public:
+	void init(int maxDelay)
+	{
+		m_buffer.assign((size_t)std::max(1, maxDelay), SampleType(0));
+		setDelay(0);
+	}
+
+	// Clears the buffer, the delay is only changed between blocks
+	void setDelay(int delay)
+	{
+		m_delay = std::clamp(delay, 0, (int)m_buffer.size());
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_buffer.begin(), m_buffer.end(), SampleType(0));
+		m_position = 0;
+	}
+
+	int getDelay() const { return m_delay; }
+
+	// In place, the block swaps with the oldest samples of the ring
+	void process(SampleType* data, int samples)
+	{
+		if (m_delay == 0)
+			return;
+
+		SampleType* buffer = m_buffer.data();
+
+		for (int done = 0; done < samples;)
+		{
+			const int chunk = std::min(samples - done, m_delay - m_position);
+
+			std::swap_ranges(data + done, data + done + chunk, buffer + m_position);
+
+			done += chunk;
+			m_position += chunk;
+
+			if (m_position == m_delay)
+				m_position = 0;
+		}
+	}
+
+private:
+	std::vector<SampleType> m_buffer;
+	int m_delay = 0;
+	int m_position = 0;
+};
+
+//==============================================================================
+// Maximum of the absolute input over the last window samples, the current one included
+template<typename SampleType>
+class SlidingMaximum
+{
+public:
+	void init(int maxWindow)
+	{
+		// Power of two ring, the deque never holds more than window entries
+		int capacity = 1;
+		while (capacity < maxWindow)
+			capacity <<= 1;
+
+		m_values.assign((size_t)capacity, SampleType(0));
+		m_indices.assign((size_t)capacity, 0);
+		m_mask = (uint32_t)(capacity - 1);
+
+		setWindow(1);
+	}
+
+	void setWindow(int window)
+	{
+		m_window = (uint32_t)std::clamp(window, 1, (int)m_values.size());
+		reset();
+	}
+
+	void reset()
+	{
+		m_front = 0;
+		m_back = 0;
+		m_index = 0;
+	}
+
+	void process(const SampleType* in, SampleType* out, int samples)
+	{
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			const SampleType value = std::abs(in[sample]);
+
+			// Older entries not above the new value can never be the maximum again
+			while (m_back != m_front && m_values[(m_back - 1) & m_mask] <= value)
+				--m_back;
+
+			m_values[m_back & m_mask] = value;
+			m_indices[m_back & m_mask] = m_index;
+			++m_back;
+
+			// Unsigned difference stays correct when the index wraps
+			if (m_index - m_indices[m_front & m_mask] >= m_window)
+				++m_front;
+
+			out[sample] = m_values[m_front & m_mask];
+			++m_index;
+		}
+	}
+
+private:
+	std::vector<SampleType> m_values;
+	std::vector<uint32_t> m_indices;
+	uint32_t m_mask = 0;
+	uint32_t m_window = 1;
+
+	uint32_t m_front = 0;
+	uint32_t m_back = 0;
+	uint32_t m_index = 0;
+};
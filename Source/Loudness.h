@@ -0,0 +1,362 @@
+/*
+  ==============================================================================
+
+    Streaming ITU-R BS.1770 loudness of the input and output, and the
+    makeup gain that keeps them equal.
+
+    Both sides are K-weighted, a high shelf and the RLB high pass with the
+    coefficients of the standard derived for the sample rate, and their
+    channel weighted power is summed into 100 ms hops. Every hop closes a
+    400 ms momentary block, 75 % overlap as the standard gates them, and
+    the short-term window is the last 3 s of hops.
+
+    Once per hop the blocks of the window are gated on the input, -70 LUFS
+    absolute and 10 LU below the mean of the blocks passing that, and the
+    makeup gain is the difference of the input and output energy of the
+    same blocks. Gating on the input only keeps the gain from chasing
+    passages the compressor pushed under a gate. The per sample work is the
+    filters and a sum, the gating runs at the hop rate. State is allocated
+    in prepare, measuring does not allocate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+
+//==============================================================================
+class LoudnessMeter
+{
+public:
+	static constexpr double HOP_SECONDS = 0.1;
+	static constexpr int MOMENTARY_HOPS = 4;
+	static constexpr int SHORT_TERM_HOPS = 30;
+	static constexpr int BLOCKS = SHORT_TERM_HOPS - MOMENTARY_HOPS + 1;
+
+	static constexpr double ABSOLUTE_GATE_LUFS = -70.0;
+	static constexpr double RELATIVE_GATE_LU = -10.0;
+
+	// Loudness of a mean square of 1, the level offset of BS.1770
+	static constexpr double LOUDNESS_OFFSET = -0.691;
+
+	static constexpr float MAX_MAKEUP_DB = 24.0f;
+
+	// maxSamples is the longest measured block
+	void prepare(int channels, double sampleRate, int maxSamples)
+	{
+		m_channels = channels;
+		m_hopSamples = std::max(1, (int)std::lround(HOP_SECONDS * sampleRate));
+
+		m_shelf = getShelf(sampleRate);
+		m_highPass = getHighPass(sampleRate);
+
+		m_weights.assign((size_t)channels, 1.0);
+		m_inputState.assign((size_t)channels, FilterState());
+		m_outputState.assign((size_t)channels, FilterState());
+		m_inputPower.assign((size_t)maxSamples, 0.0);
+
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_inputState.begin(), m_inputState.end(), FilterState());
+		std::fill(m_outputState.begin(), m_outputState.end(), FilterState());
+
+		m_hopInput.fill(0.0);
+		m_hopOutput.fill(0.0);
+		m_blockInput.fill(0.0);
+		m_blockOutput.fill(0.0);
+
+		m_hopPosition = 0;
+		m_hops = 0;
+		m_blockPosition = 0;
+		m_blocks = 0;
+
+		m_inputSum = 0.0;
+		m_outputSum = 0.0;
+		m_hopFill = 0;
+
+		m_makeupdB = 0.0f;
+	}
+
+	// Link weights, amplitude weights normalized to unity sum. The smallest non zero one is taken as a front
+	// channel of power weight 1, the others are squared relative to it, surrounds get back their 1.41
+	void setWeights(const float* weights)
+	{
+		double front = 0.0;
+
+		for (int channel = 0; channel < m_channels; ++channel)
+			if (weights[channel] > 0.0f && (front == 0.0 || weights[channel] < front))
+				front = weights[channel];
+
+		for (int channel = 0; channel < m_channels; ++channel)
+		{
+			const double relative = (front > 0.0) ? weights[channel] / front : 1.0;
+			m_weights[(size_t)channel] = relative * relative;
+		}
+	}
+
+	// Before the block is processed, any length up to maxSamples
+	template<typename SampleType>
+	void measureInput(const SampleType* const* in, int samples)
+	{
+		// Sample major, the recursions of the channels are independent and overlap
+		for (int sample = 0; sample < samples; ++sample)
+			m_inputPower[(size_t)sample] = weightedPower(in, m_inputState, sample);
+	}
+
+	// The same samples after processing, before the makeup gain. True when a hop closed and the gain may have moved.
+	// trim is a gain already in the output that the makeup keeps, a volume control, it is left out of the loudness
+	template<typename SampleType>
+	bool measureOutput(const SampleType* const* out, int samples, float trim = 1.0f)
+	{
+		// The filters are linear, the trim divides out of the power
+		const double trimPower = 1.0 / std::max((double)trim * trim, 1e-12);
+
+		// Hop by hop, the input power of the span was kept by measureInput
+		bool updated = false;
+		int sample = 0;
+
+		while (sample < samples)
+		{
+			const int length = std::min(samples - sample, m_hopSamples - m_hopFill);
+
+			// Local sums, the filter states are doubles as well and could alias the members
+			double inputSum = 0.0;
+			double outputSum = 0.0;
+
+			for (const int end = sample + length; sample < end; ++sample)
+			{
+				inputSum += m_inputPower[(size_t)sample];
+				outputSum += weightedPower(out, m_outputState, sample);
+			}
+
+			m_inputSum += inputSum;
+			m_outputSum += outputSum * trimPower;
+			m_hopFill += length;
+
+			if (m_hopFill == m_hopSamples)
+			{
+				closeHop();
+				updated = true;
+			}
+		}
+
+		return updated;
+	}
+
+	// Gated input to output difference, held while the window is gated out
+	float getMakeupdB() const { return m_makeupdB; }
+
+	// Ungated loudness of the last 3 s of the input, shorter while it fills
+	float getShortTermLoudness() const
+	{
+		const int hops = std::min(m_hops, SHORT_TERM_HOPS);
+		double sum = 0.0;
+
+		for (int hop = 0; hop < hops; ++hop)
+			sum += m_hopInput[(size_t)hop];
+
+		return (hops > 0) ? (float)toLoudness(sum / hops) : FastMath::minusInfinityDb;
+	}
+
+private:
+	struct Biquad
+	{
+		double b0, b1, b2, a1, a2;
+	};
+
+	// Transposed direct form II, shelf then high pass
+	struct FilterState
+	{
+		double shelf1 = 0.0, shelf2 = 0.0;
+		double highPass1 = 0.0, highPass2 = 0.0;
+	};
+
+	// Below it the states are flushed at the end of a hop, the filters would decay into denormals on silence
+	static constexpr double STATE_FLOOR = 1.0e-30;
+
+	// Pre-filter of BS.1770, analog prototype matched to the coefficients of the standard at 48 kHz
+	static Biquad getShelf(double sampleRate)
+	{
+		const double f0 = 1681.974450955533;
+		const double gain = 3.999843853973347;
+		const double q = 0.7071752369554196;
+
+		const double k = std::tan(FastMath::pi * f0 / sampleRate);
+		const double vh = std::pow(10.0, gain / 20.0);
+		const double vb = std::pow(vh, 0.4996667741545416);
+		const double a0 = 1.0 + k / q + k * k;
+
+		return { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+		         2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+	}
+
+	// RLB weighting, unity gain high pass
+	static Biquad getHighPass(double sampleRate)
+	{
+		const double f0 = 38.13547087602444;
+		const double q = 0.5003270373238773;
+
+		const double k = std::tan(FastMath::pi * f0 / sampleRate);
+		const double a0 = 1.0 + k / q + k * k;
+
+		return { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+	}
+
+	inline double kWeighting(double x, FilterState& state) const
+	{
+		const double shelf = m_shelf.b0 * x + state.shelf1;
+		state.shelf1 = m_shelf.b1 * x - m_shelf.a1 * shelf + state.shelf2;
+		state.shelf2 = m_shelf.b2 * x - m_shelf.a2 * shelf;
+
+		const double y = m_highPass.b0 * shelf + state.highPass1;
+		state.highPass1 = m_highPass.b1 * shelf - m_highPass.a1 * y + state.highPass2;
+		state.highPass2 = m_highPass.b2 * shelf - m_highPass.a2 * y;
+
+		return y;
+	}
+
+	// Channel weighted K-weighted power of one sample
+	template<typename SampleType>
+	inline double weightedPower(const SampleType* const* in, std::vector<FilterState>& states, int sample)
+	{
+		double power = 0.0;
+
+		for (int channel = 0; channel < m_channels; ++channel)
+		{
+			const double y = kWeighting((double)in[channel][sample], states[(size_t)channel]);
+			power += m_weights[(size_t)channel] * y * y;
+		}
+
+		return power;
+	}
+
+	static double toLoudness(double meanSquare)
+	{
+		return (meanSquare > 0.0) ? LOUDNESS_OFFSET + 10.0 * std::log10(meanSquare) : (double)FastMath::minusInfinityDb;
+	}
+
+	static double toMeanSquare(double loudness) { return std::pow(10.0, (loudness - LOUDNESS_OFFSET) / 10.0); }
+
+	void closeHop()
+	{
+		m_hopInput[(size_t)m_hopPosition] = m_inputSum / m_hopSamples;
+		m_hopOutput[(size_t)m_hopPosition] = m_outputSum / m_hopSamples;
+		m_hopPosition = (m_hopPosition + 1) % SHORT_TERM_HOPS;
+		m_hops = std::min(m_hops + 1, SHORT_TERM_HOPS);
+
+		m_inputSum = 0.0;
+		m_outputSum = 0.0;
+		m_hopFill = 0;
+
+		auto flush = [](double& value) { if (std::abs(value) < STATE_FLOOR) value = 0.0; };
+
+		for (auto* states : { &m_inputState, &m_outputState })
+			for (auto& state : *states)
+			{
+				flush(state.shelf1);
+				flush(state.shelf2);
+				flush(state.highPass1);
+				flush(state.highPass2);
+			}
+
+		if (m_hops < MOMENTARY_HOPS)
+			return;
+
+		// Momentary block of the last 4 hops
+		double blockInput = 0.0;
+		double blockOutput = 0.0;
+
+		for (int hop = 1; hop <= MOMENTARY_HOPS; ++hop)
+		{
+			const int position = (m_hopPosition - hop + SHORT_TERM_HOPS) % SHORT_TERM_HOPS;
+			blockInput += m_hopInput[(size_t)position];
+			blockOutput += m_hopOutput[(size_t)position];
+		}
+
+		m_blockInput[(size_t)m_blockPosition] = blockInput / MOMENTARY_HOPS;
+		m_blockOutput[(size_t)m_blockPosition] = blockOutput / MOMENTARY_HOPS;
+		m_blockPosition = (m_blockPosition + 1) % BLOCKS;
+		m_blocks = std::min(m_blocks + 1, BLOCKS);
+
+		updateMakeup();
+	}
+
+	// Two pass gating of BS.1770 over the short-term window, decided on the input blocks
+	void updateMakeup()
+	{
+		auto gatedSums = [this](double gate, double& input, double& output)
+		{
+			input = output = 0.0;
+			int count = 0;
+
+			for (int block = 0; block < m_blocks; ++block)
+			{
+				if (m_blockInput[(size_t)block] > gate)
+				{
+					input += m_blockInput[(size_t)block];
+					output += m_blockOutput[(size_t)block];
+					++count;
+				}
+			}
+
+			return count;
+		};
+
+		const double absoluteGate = toMeanSquare(ABSOLUTE_GATE_LUFS);
+
+		double input = 0.0;
+		double output = 0.0;
+		const int count = gatedSums(absoluteGate, input, output);
+
+		// Silence, the last gain holds
+		if (count == 0)
+			return;
+
+		const double relativeGate = std::max(absoluteGate, input / count * std::pow(10.0, RELATIVE_GATE_LU / 10.0));
+		gatedSums(relativeGate, input, output);
+
+		// Silent output of an audible input would ask for an unbounded gain
+		if (output <= 0.0)
+			return;
+
+		m_makeupdB = std::clamp((float)(10.0 * std::log10(input / output)), -MAX_MAKEUP_DB, MAX_MAKEUP_DB);
+	}
+
+	int m_channels = 0;
+	int m_hopSamples = 1;
+
+	Biquad m_shelf{};
+	Biquad m_highPass{};
+
+	std::vector<double> m_weights;
+	std::vector<FilterState> m_inputState;
+	std::vector<FilterState> m_outputState;
+
+	// K-weighted input power of the block between measureInput and measureOutput
+	std::vector<double> m_inputPower;
+
+	// Mean square of the last hops and momentary blocks, rings
+	std::array<double, SHORT_TERM_HOPS> m_hopInput{};
+	std::array<double, SHORT_TERM_HOPS> m_hopOutput{};
+	std::array<double, BLOCKS> m_blockInput{};
+	std::array<double, BLOCKS> m_blockOutput{};
+	int m_hopPosition = 0;
+	int m_hops = 0;
+	int m_blockPosition = 0;
+	int m_blocks = 0;
+
+	// Sums of the open hop
+	double m_inputSum = 0.0;
+	double m_outputSum = 0.0;
+	int m_hopFill = 0;
+
+	float m_makeupdB = 0.0f;
+};
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Meter values from the audio thread to the editor or a logger.
+
+    MeterFrame is filled once per processed block, MeterQueue hands frames
+    over through a ring of atomic indices, wait free on both ends. Single
+    producer and single consumer, so either the editor or a logger reads a
+    processor. No JUCE dependency, the engine library uses it as well.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <algorithm>
+
+//==============================================================================
+// One processed block, gain reduction as positive dB
+struct MeterFrame
+{
+	float gainReductionPeakdB = 0.0f;
+	float gainReductionAveragedB = 0.0f;
+	float inputPeakdB = -100.0f;
+	float outputPeakdB = -100.0f;
+
+	// Effective times, auto timing shortens them
+	float attackTime = 0.0f;
+	float releaseTime = 0.0f;
+	float crestFactorPercentage = 0.0f;
+
+	// Auto makeup gain and the short-term input loudness in LUFS it follows, the latest
+	float makeupdB = 0.0f;
+	float shortTermLoudness = -100.0f;
+
+	int samples = 0;
+
+	// Peaks take the maximum, averages are weighted by length, times are the latest
+	void merge(const MeterFrame& other)
+	{
+		const int total = samples + other.samples;
+
+		if (total > 0)
+			gainReductionAveragedB = (gainReductionAveragedB * samples + other.gainReductionAveragedB * other.samples) / total;
+
+		gainReductionPeakdB = std::max(gainReductionPeakdB, other.gainReductionPeakdB);
+		inputPeakdB = std::max(inputPeakdB, other.inputPeakdB);
+		outputPeakdB = std::max(outputPeakdB, other.outputPeakdB);
+		crestFactorPercentage = std::max(crestFactorPercentage, other.crestFactorPercentage);
+
+		attackTime = other.attackTime;
+		releaseTime = other.releaseTime;
+		makeupdB = other.makeupdB;
+		shortTermLoudness = other.shortTermLoudness;
+		samples = total;
+	}
+};
+
+//==============================================================================
+template<typename Type, int Capacity>
+class MeterQueue
+{
+public:
+	// Audio thread, drops the value when the reader falls behind
+	bool push(const Type& value)
+	{
+		const int write = m_write.load(std::memory_order_relaxed);
+		const int next = (write + 1) % SIZE;
+
+		if (next == m_read.load(std::memory_order_acquire))
+			return false;
+
+		m_buffer[write] = value;
+		m_write.store(next, std::memory_order_release);
+
+		return true;
+	}
+
+	bool pop(Type& value)
+	{
+		const int read = m_read.load(std::memory_order_relaxed);
+
+		if (read == m_write.load(std::memory_order_acquire))
+			return false;
+
+		value = m_buffer[read];
+		m_read.store((read + 1) % SIZE, std::memory_order_release);
+
+		return true;
+	}
+
+	int getNumReady() const { return (m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire) + SIZE) % SIZE; }
+
+private:
+	// One slot stays free to tell full from empty
+	static constexpr int SIZE = Capacity + 1;
+
+	std::atomic<int> m_write{ 0 };
+	std::atomic<int> m_read{ 0 };
+	std::array<Type, SIZE> m_buffer;
+};
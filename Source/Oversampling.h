@@ -0,0 +1,313 @@
+/*
+  ==============================================================================
+
+    2x / 4x / 8x oversampling with cascaded polyphase half-band FIR stages.
+
+    Every other tap of a half-band filter is zero, so each 2x stage splits in
+    a short FIR branch and a pure delay branch. The FIR branch runs 8 output
+    samples at a time with FastMath::Vec4 for float, double runs scalar.
+    Buffers are allocated in prepare, processing does not allocate.
+
+    Stage    Taps    Delay at stage rate
+    1        63      31
+    2        23      11
+    3        15      7
+
+    Kaiser window, stopband about -80 dB, passband flat to 0.42 of the base
+    sample rate. Latency up and down at the base rate: 2x 31, 4x 36.5 and
+    8x 38.25 samples, reported rounded.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+
+//==============================================================================
+template<typename SampleType>
+class HalfBandStage
+{
+public:
+	// sideTaps non zero taps on each side of the centre, multiple of 2
+	void init(int sideTaps, int maxInputSamples)
+	{
+		m_sideTaps = sideTaps;
+
+		const int branchTaps = 2 * sideTaps;
+		const int length = 4 * sideTaps - 1;
+		const int centre = length / 2;
+
+		// Windowed sinc, only the even taps are non zero beside the centre
+		std::vector<double> branch((size_t)branchTaps);
+		double sum = 0.0;
+
+		for (int j = 0; j < branchTaps; ++j)
+		{
+			const double t = 2.0 * j - centre;
+			const double sinc = std::sin(FastMath::pi * t * 0.5) / (FastMath::pi * t);
+			const double x = t / (centre + 1);
+			const double window = besselI0(KAISER_BETA * std::sqrt(1.0 - x * x)) / besselI0(KAISER_BETA);
+
+			branch[(size_t)j] = sinc * window;
+			sum += sinc * window;
+		}
+
+		// Branch sums to 0.5, unity gain at DC
+		m_coefficients.resize((size_t)branchTaps);
+		for (int i = 0; i < branchTaps; ++i)
+			m_coefficients[(size_t)i] = (SampleType)(branch[(size_t)(branchTaps - 1 - i)] * 0.5 / sum);
+
+		m_upHistory.assign((size_t)(branchTaps - 1 + maxInputSamples), SampleType(0));
+		m_downEven.assign((size_t)(branchTaps - 1 + maxInputSamples), SampleType(0));
+		m_downOdd.assign((size_t)(sideTaps + maxInputSamples), SampleType(0));
+		m_branch.assign((size_t)maxInputSamples, SampleType(0));
+	}
+
+	void reset()
+	{
+		std::fill(m_upHistory.begin(), m_upHistory.end(), SampleType(0));
+		std::fill(m_downEven.begin(), m_downEven.end(), SampleType(0));
+		std::fill(m_downOdd.begin(), m_downOdd.end(), SampleType(0));
+	}
+
+	// Group delay in samples at the higher rate, for each direction
+	static int getDelay(int sideTaps) { return 2 * sideTaps - 1; }
+
+	// samples in, 2 * samples out
+	void up(const SampleType* in, SampleType* out, int samples)
+	{
+		const int history = 2 * m_sideTaps - 1;
+		SampleType* buffer = m_upHistory.data();
+
+		std::copy(in, in + samples, buffer + history);
+
+		// Even outputs from the FIR branch, doubled for the zero stuffing
+		convolve(buffer, m_coefficients.data(), 2 * m_sideTaps, m_branch.data(), samples, SampleType(2));
+
+		// Odd outputs are the delayed input, the centre tap
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			out[2 * sample] = m_branch[(size_t)sample];
+			out[2 * sample + 1] = buffer[m_sideTaps + sample];
+		}
+
+		std::copy(buffer + samples, buffer + samples + history, buffer);
+	}
+
+	// 2 * samples in, samples out
+	void down(const SampleType* in, SampleType* out, int samples)
+	{
+		const int history = 2 * m_sideTaps - 1;
+		SampleType* even = m_downEven.data();
+		SampleType* odd = m_downOdd.data();
+
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			even[history + sample] = in[2 * sample];
+			odd[m_sideTaps + sample] = in[2 * sample + 1];
+		}
+
+		convolve(even, m_coefficients.data(), 2 * m_sideTaps, out, samples, SampleType(1));
+
+		// Centre tap on the odd phase
+		FastMath::transform(out, odd, out, samples, [](auto branch, auto centre)
+		{
+			using Type = decltype(branch);
+			return branch + Type(0.5f) * centre;
+		});
+
+		std::copy(even + samples, even + samples + history, even);
+		std::copy(odd + samples, odd + samples + m_sideTaps, odd);
+	}
+
+private:
+	static constexpr double KAISER_BETA = 8.0;
+
+	static double besselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x * 0.5 / k) * (x * 0.5 / k);
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	// out[m] = gain * sum coefficients[i] * in[m + i], 8 outputs per step
+	static void convolve(const SampleType* in, const SampleType* coefficients, int taps, SampleType* out, int samples, SampleType gain)
+	{
+		int sample = 0;
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+		if constexpr (std::is_same<SampleType, float>::value)
+			convolveVec4(in, coefficients, taps, out, samples, gain, sample);
+#endif
+
+		for (; sample < samples; ++sample)
+		{
+			SampleType sum = 0;
+
+			for (int i = 0; i < taps; ++i)
+				sum += coefficients[i] * in[sample + i];
+
+			out[sample] = gain * sum;
+		}
+	}
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+	// Whole groups of 4, sample is left on the first output of the scalar tail
+	static void convolveVec4(const float* in, const float* coefficients, int taps, float* out, int samples, float gain, int& sample)
+	{
+		using FastMath::Vec4;
+
+		// Two independent sums hide the add latency
+		for (; sample + 8 <= samples; sample += 8)
+		{
+			Vec4 sum0(0.0f);
+			Vec4 sum1(0.0f);
+
+			for (int i = 0; i < taps; ++i)
+			{
+				const Vec4 coefficient(coefficients[i]);
+				sum0 = sum0 + coefficient * Vec4::load(in + sample + i);
+				sum1 = sum1 + coefficient * Vec4::load(in + sample + i + 4);
+			}
+
+			(sum0 * Vec4(gain)).store(out + sample);
+			(sum1 * Vec4(gain)).store(out + sample + 4);
+		}
+
+		for (; sample + 4 <= samples; sample += 4)
+		{
+			Vec4 sum(0.0f);
+
+			for (int i = 0; i < taps; ++i)
+				sum = sum + Vec4(coefficients[i]) * Vec4::load(in + sample + i);
+
+			(sum * Vec4(gain)).store(out + sample);
+		}
+	}
+#endif
+
+	int m_sideTaps = 0;
+
+	// FIR branch, reversed
+	std::vector<SampleType> m_coefficients;
+
+	// Previous inputs followed by the current block
+	std::vector<SampleType> m_upHistory;
+	std::vector<SampleType> m_downEven;
+	std::vector<SampleType> m_downOdd;
+	std::vector<SampleType> m_branch;
+};
+
+//==============================================================================
+// Cascade of half-band stages for every channel, up to 8x
+struct OversamplerStages
+{
+	static constexpr int MAX_STAGES = 3;
+	static constexpr int MAX_FACTOR = 1 << MAX_STAGES;
+
+	// Non zero taps on each side of the centre per stage
+	static constexpr int SIDE_TAPS[MAX_STAGES] = { 16, 6, 4 };
+
+	// Up and down together at the base rate
+	static float getLatency(int stages)
+	{
+		float latency = 0.0f;
+
+		for (int stage = 0; stage < stages; ++stage)
+			latency += (float)HalfBandStage<float>::getDelay(SIDE_TAPS[stage]) / (float)(1 << stage);
+
+		return latency;
+	}
+};
+
+template<typename SampleType>
+class Oversampler : public OversamplerStages
+{
+public:
+	// Allocates for MAX_STAGES, the factor can change later without allocation
+	void prepare(int channels, int maxSamples)
+	{
+		m_channels = channels;
+		m_stages.resize((size_t)(channels * MAX_STAGES));
+		m_buffers.resize((size_t)(channels * MAX_STAGES));
+		m_pointers.assign((size_t)channels, nullptr);
+
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			for (int stage = 0; stage < MAX_STAGES; ++stage)
+			{
+				const int stageInput = maxSamples << stage;
+
+				getStage(channel, stage).init(SIDE_TAPS[stage], stageInput);
+				m_buffers[(size_t)(channel * MAX_STAGES + stage)].assign((size_t)(2 * stageInput), SampleType(0));
+			}
+		}
+	}
+
+	void reset()
+	{
+		for (auto& stage : m_stages)
+			stage.reset();
+	}
+
+	void setStages(int stages) { m_activeStages = std::clamp(stages, 0, MAX_STAGES); }
+	int getStages() const { return m_activeStages; }
+	int getFactor() const { return 1 << m_activeStages; }
+
+	float getLatency() const { return OversamplerStages::getLatency(m_activeStages); }
+
+	// Returns the oversampled channels, samples * getFactor() long
+	SampleType* const* up(const SampleType* const* in, int channels, int samples)
+	{
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			const SampleType* stageIn = in[channel];
+
+			for (int stage = 0; stage < m_activeStages; ++stage)
+			{
+				SampleType* stageOut = getBuffer(channel, stage);
+				getStage(channel, stage).up(stageIn, stageOut, samples << stage);
+				stageIn = stageOut;
+			}
+
+			m_pointers[(size_t)channel] = const_cast<SampleType*>(stageIn);
+		}
+
+		return m_pointers.data();
+	}
+
+	// Oversampled channels from up back to samples at the base rate
+	void down(SampleType* const* out, int channels, int samples)
+	{
+		for (int channel = 0; channel < channels; ++channel)
+		{
+			for (int stage = m_activeStages - 1; stage >= 0; --stage)
+			{
+				SampleType* stageOut = (stage > 0) ? getBuffer(channel, stage - 1) : out[channel];
+				getStage(channel, stage).down(getBuffer(channel, stage), stageOut, samples << stage);
+			}
+		}
+	}
+
+private:
+	HalfBandStage<SampleType>& getStage(int channel, int stage) { return m_stages[(size_t)(channel * MAX_STAGES + stage)]; }
+	SampleType* getBuffer(int channel, int stage) { return m_buffers[(size_t)(channel * MAX_STAGES + stage)].data(); }
+
+	int m_channels = 0;
+	int m_activeStages = 0;
+
+	std::vector<HalfBandStage<SampleType>> m_stages;
+	std::vector<std::vector<SampleType>> m_buffers;
+	std::vector<SampleType*> m_pointers;
+};
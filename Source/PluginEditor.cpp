@@ -17,9 +17,12 @@ CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioP
 	juce::Colour medium = juce::Colour::fromHSV(HUE * 0.01f, 0.5f, 0.5f, 1.0f);
 	juce::Colour dark = juce::Colour::fromHSV(HUE * 0.01f, 0.5f, 0.4f, 1.0f);
 
-	getLookAndFeel().setColour(juce::Slider::thumbColourId, dark);
-	getLookAndFeel().setColour(juce::Slider::rotarySliderFillColourId, medium);
-	getLookAndFeel().setColour(juce::Slider::rotarySliderOutlineColourId, light);
+	m_lookAndFeel.setColour(juce::Slider::thumbColourId, dark);
+	m_lookAndFeel.setColour(juce::Slider::rotarySliderFillColourId, medium);
+	m_lookAndFeel.setColour(juce::Slider::rotarySliderOutlineColourId, light);
+	setLookAndFeel(&m_lookAndFeel);
+
+	setOpaque(true);
 
 	for (int i = 0; i < N_SLIDERS_COUNT; i++)
 	{
@@ -35,6 +38,9 @@ CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioP
 		//Slider
 		slider.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
 		slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 80, 20);
+
+		// Knob redrawn into its image only when the value changes
+		slider.setBufferedToImage(true);
 		addAndMakeVisible(slider);
 		m_sliderAttachment[i].reset(new SliderAttachment(valueTreeState, CompressorAudioProcessor::paramsNames[i], slider));
 	}
@@ -50,8 +56,7 @@ CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioP
 	detectionTypeLabel.setJustificationType(juce::Justification::centred);
 	addAndMakeVisible(detectionTypeLabel);
 
-#if DEBUG
-	//Debug
+	//Meters
 	crestFactorLabel.setText("0", juce::dontSendNotification);
 	crestFactorLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
 	crestFactorLabel.setJustificationType(juce::Justification::centred);
@@ -71,7 +76,16 @@ CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioP
 	releaseTimeLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
 	releaseTimeLabel.setJustificationType(juce::Justification::centred);
 	addAndMakeVisible(releaseTimeLabel);
-#endif
+
+	inputLevelLabel.setText("0", juce::dontSendNotification);
+	inputLevelLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
+	inputLevelLabel.setJustificationType(juce::Justification::centred);
+	addAndMakeVisible(inputLevelLabel);
+
+	outputLevelLabel.setText("0", juce::dontSendNotification);
+	outputLevelLabel.setFont(juce::Font(24.0f * 0.01f * SCALE, juce::Font::bold));
+	outputLevelLabel.setJustificationType(juce::Justification::centred);
+	addAndMakeVisible(outputLevelLabel);
 
 	// Buttons
 	addAndMakeVisible(typeAButton);
@@ -104,46 +118,220 @@ CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioP
 	typeCButton.setColour(juce::TextButton::buttonOnColourId, dark);
 	typeDButton.setColour(juce::TextButton::buttonOnColourId, dark);
 
-#if DEBUG
-	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)((SLIDER_WIDTH + BOTTOM_MENU_HEIGHT + BOTTOM_MENU_HEIGHT) * 0.01f * SCALE));
+	// Auto makeup, lit while it is on, the gain it applies next to it
+	addAndMakeVisible(autoMakeupButton);
+	autoMakeupButton.setClickingTogglesState(true);
+	autoMakeupAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(valueTreeState, "AutoMakeup", autoMakeupButton));
+
+	autoMakeupButton.setColour(juce::TextButton::buttonColourId, light);
+	autoMakeupButton.setColour(juce::TextButton::buttonOnColourId, dark);
+
+	makeupLabel.setFont(juce::Font(20.0f * 0.01f * SCALE, juce::Font::plain));
+	makeupLabel.setJustificationType(juce::Justification::centredRight);
+	addAndMakeVisible(makeupLabel);
+
+	// Attack and release automation
+	automationTLabel.setText("Timing :", juce::dontSendNotification);
+	automationTLabel.setFont(juce::Font(22.0f * 0.01f * SCALE, juce::Font::plain));
+	automationTLabel.setJustificationType(juce::Justification::centredRight);
+	addAndMakeVisible(automationTLabel);
+
+	automationComboBox.addItemList(CompressorAudioProcessor::automationNames, 1);
+	addAndMakeVisible(automationComboBox);
+	automationAttachment.reset(new ComboBoxAttachment(valueTreeState, "Automation", automationComboBox));
+
+	// Channel link
+	linkLabel.setText("Link :", juce::dontSendNotification);
+	linkLabel.setFont(juce::Font(22.0f * 0.01f * SCALE, juce::Font::plain));
+	linkLabel.setJustificationType(juce::Justification::centredRight);
+	addAndMakeVisible(linkLabel);
+
+	linkComboBox.addItemList(CompressorAudioProcessor::linkNames, 1);
+	addAndMakeVisible(linkComboBox);
+	linkAttachment.reset(new ComboBoxAttachment(valueTreeState, "Link", linkComboBox));
+
+	// Oversampling
+	addOptionLabel(oversamplingLabel, "Oversampling :");
+
+	oversamplingComboBox.addItemList(CompressorAudioProcessor::oversamplingNames, 1);
+	addAndMakeVisible(oversamplingComboBox);
+	oversamplingAttachment.reset(new ComboBoxAttachment(valueTreeState, "Oversampling", oversamplingComboBox));
+
+	// Detector and RMS window
+	addOptionLabel(detectorLabel, "Detector :");
+
+	detectorComboBox.addItemList(CompressorAudioProcessor::detectorNames, 1);
+	detectorComboBox.onChange = [this] { updateRmsWindow(); };
+	addAndMakeVisible(detectorComboBox);
+	detectorAttachment.reset(new ComboBoxAttachment(valueTreeState, "Detector", detectorComboBox));
+
+	addOptionLabel(rmsWindowLabel, "RMS Window :");
+
+	rmsWindowSlider.setSliderStyle(juce::Slider::SliderStyle::LinearBar);
+	rmsWindowSlider.setTextValueSuffix(" ms");
+	addAndMakeVisible(rmsWindowSlider);
+	rmsWindowAttachment.reset(new SliderAttachment(valueTreeState, "RMSWindow", rmsWindowSlider));
+
+	updateRmsWindow();
+
+	// Bands and crossovers
+	addOptionLabel(bandsLabel, "Bands :");
+
+	bandsComboBox.addItemList(CompressorAudioProcessor::bandsNames, 1);
+	bandsComboBox.onChange = [this] { updateCrossovers(); };
+	addAndMakeVisible(bandsComboBox);
+	bandsAttachment.reset(new ComboBoxAttachment(valueTreeState, "Bands", bandsComboBox));
+
+	addOptionLabel(crossoverLabel, "Crossovers :");
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+	{
+		auto& slider = crossoverSliders[split];
+
+		slider.setSliderStyle(juce::Slider::SliderStyle::LinearBar);
+		slider.setTextValueSuffix(" Hz");
+		addAndMakeVisible(slider);
+		crossoverAttachments[split].reset(new SliderAttachment(valueTreeState, "Crossover" + juce::String(split + 1), slider));
+	}
+
+	updateCrossovers();
+
+	// Sidechain and key filter
+	addOptionLabel(sidechainLabel, "Sidechain :");
+
+	addAndMakeVisible(sidechainButton);
+	sidechainAttachment.reset(new juce::AudioProcessorValueTreeState::ButtonAttachment(valueTreeState, "Sidechain", sidechainButton));
+
+	addOptionLabel(keyFilterLabel, "Key Filter :");
+
+	keyFilterComboBox.addItemList(CompressorAudioProcessor::keyFilterNames, 1);
+	keyFilterComboBox.onChange = [this] { updateKeyFrequency(); };
+	addAndMakeVisible(keyFilterComboBox);
+	keyFilterAttachment.reset(new ComboBoxAttachment(valueTreeState, "KeyFilter", keyFilterComboBox));
+
+	addOptionLabel(keyFrequencyLabel, "Key Frequency :");
+
+	keyFrequencySlider.setSliderStyle(juce::Slider::SliderStyle::LinearBar);
+	keyFrequencySlider.setTextValueSuffix(" Hz");
+	addAndMakeVisible(keyFrequencySlider);
+	keyFrequencyAttachment.reset(new SliderAttachment(valueTreeState, "KeyFrequency", keyFrequencySlider));
+
+	updateKeyFrequency();
+
+	// Gain reduction history and transfer curve
+	addAndMakeVisible(m_history);
+	addAndMakeVisible(m_transferCurve);
+
+	m_thresholdParameter = valueTreeState.getRawParameterValue("Threshold");
+	m_ratioParameter = valueTreeState.getRawParameterValue("Ratio");
+	m_mixParameter = valueTreeState.getRawParameterValue("Mix");
+	m_volumeParameter = valueTreeState.getRawParameterValue("Volume");
+
+	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)((SLIDER_WIDTH + BOTTOM_MENU_HEIGHT * (2 + OPTION_ROWS) + DISPLAY_HEIGHT) * 0.01f * SCALE));
 
-	startTimerHz(5);
-#else
-	setSize((int)(SLIDER_WIDTH * 0.01f * SCALE * N_SLIDERS_COUNT), (int)((SLIDER_WIDTH + BOTTOM_MENU_HEIGHT) * 0.01f * SCALE));
-#endif
+	// Skip frames queued while the editor was closed
+	MeterFrame frame;
+	audioProcessor.popMeterFrames(frame);
+
+	startTimerHz(FRAME_RATE);
 }
 
 CompressorAudioProcessorEditor::~CompressorAudioProcessorEditor()
 {
+	setLookAndFeel(nullptr);
+}
+
+void CompressorAudioProcessorEditor::addOptionLabel(juce::Label& label, const juce::String& text)
+{
+	label.setText(text, juce::dontSendNotification);
+	label.setFont(juce::Font(22.0f * 0.01f * SCALE, juce::Font::plain));
+	label.setJustificationType(juce::Justification::centredRight);
+	addAndMakeVisible(label);
+}
+
+void CompressorAudioProcessorEditor::updateCrossovers()
+{
+	// Choice index + 1 is the number of bands
+	const int bands = bandsComboBox.getSelectedItemIndex() + 1;
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+		crossoverSliders[split].setEnabled(split < bands - 1);
+}
+
+void CompressorAudioProcessorEditor::updateRmsWindow()
+{
+	// Choice index 0 is Peak
+	rmsWindowSlider.setEnabled(detectorComboBox.getSelectedItemIndex() > 0);
+}
+
+void CompressorAudioProcessorEditor::updateKeyFrequency()
+{
+	// Choice index 0 is Off
+	keyFrequencySlider.setEnabled(keyFilterComboBox.getSelectedItemIndex() > 0);
 }
 
 //==============================================================================
-#ifdef DEBUG
 void CompressorAudioProcessorEditor::timerCallback()
 {
-	const int attackTime = (int)audioProcessor.getAttackTime();
+	// Everything processed since the last tick, zeros while stopped
+	MeterFrame frame;
+	if (! audioProcessor.popMeterFrames(frame))
+		frame = MeterFrame();
+
+	// Hidden editors only drain the queue
+	if (! isShowing())
+		return;
+
+	m_history.push(frame.gainReductionPeakdB);
+
+	m_transferCurve.setCurve(m_thresholdParameter->load(), m_ratioParameter->load(), m_mixParameter->load(), m_volumeParameter->load());
+	m_transferCurve.setLevel(frame.inputPeakdB);
+
+	// Volume trims on top of the auto makeup, the makeup holds while stopped
+	if (! autoMakeupButton.getToggleState())
+		m_transferCurve.setMakeup(0.0f);
+	else if (frame.samples > 0)
+		m_transferCurve.setMakeup(frame.makeupdB);
+
+	m_labelFrame.merge(frame);
+
+	if (++m_labelTicks < FRAME_RATE / LABEL_RATE)
+		return;
+
+	frame = m_labelFrame;
+	m_labelFrame = MeterFrame();
+	m_labelTicks = 0;
+
+	// Labels repaint themselves only when their text changes
+	const int attackTime = (int)frame.attackTime;
 	attackTimeLabel.setText(juce::String(attackTime), juce::dontSendNotification);
 
-	const int releaseTime = (int)audioProcessor.getReleaseTime();
+	const int releaseTime = (int)frame.releaseTime;
 	releaseTimeLabel.setText(juce::String(releaseTime), juce::dontSendNotification);
 
-	const int crestFactorSQ = (int)audioProcessor.getCrestFactor();
+	const int crestFactorSQ = (int)frame.crestFactorPercentage;
 	crestFactorLabel.setText(juce::String(crestFactorSQ), juce::dontSendNotification);
 
-	const int gainReduction = (int)audioProcessor.getGainReduction();
-	gainReductionLabel.setText(juce::String(gainReduction), juce::dontSendNotification);
-	
-	repaint();
+	gainReductionLabel.setText(juce::String(frame.gainReductionPeakdB, 1), juce::dontSendNotification);
+	inputLevelLabel.setText(juce::String(frame.inputPeakdB, 1), juce::dontSendNotification);
+	outputLevelLabel.setText(juce::String(frame.outputPeakdB, 1), juce::dontSendNotification);
+
+	// Makeup gain only while auto makeup is on
+	const juce::String makeup = autoMakeupButton.getToggleState() ? juce::String(frame.makeupdB, 1) + " dB" : juce::String();
+	makeupLabel.setText(makeup, juce::dontSendNotification);
 }
-#endif
 
 void CompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
-	g.fillAll(juce::Colour::fromHSV(HUE * 0.01f, 0.5f, 0.7f, 1.0f));
+	g.drawImageAt(m_background, 0, 0);
 }
 
 void CompressorAudioProcessorEditor::resized()
 {
+	m_background = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), false);
+	juce::Graphics background(m_background);
+	background.fillAll(juce::Colour::fromHSV(HUE * 0.01f, 0.5f, 0.7f, 1.0f));
+
 	int width = getWidth() / N_SLIDERS_COUNT;
 	int height = SLIDER_WIDTH * 0.01f * SCALE;
 
@@ -169,32 +357,81 @@ void CompressorAudioProcessorEditor::resized()
 	typeCButton.setBounds((int)(getWidth() * 0.5f + buttonHeight * 0.6f), posY, buttonHeight, buttonHeight);
 	typeDButton.setBounds((int)(getWidth() * 0.5f + buttonHeight * 1.8f), posY, buttonHeight, buttonHeight);	
 
-#if DEBUG
-	// Debug menus
+	// Auto makeup in the top corners of the Volume knob
+	const int volumePosX = VOLUME_SLIDER * width;
+	autoMakeupButton.setBounds(volumePosX + (int)(0.05f * width), (int)(0.05f * width), 2 * buttonHeight, buttonHeight);
+	makeupLabel.setBounds(volumePosX + width / 2, (int)(0.05f * width), (int)(0.45f * width), buttonHeight);
+
+	// Timing, first column
+	automationTLabel.setBounds(0, posY, width, buttonHeight);
+	automationComboBox.setBounds((int)(1.05f * width), posY, (int)(0.9f * width), buttonHeight);
+
+	// Link, last column
+	linkLabel.setBounds(getWidth() - 2 * width, posY, width, buttonHeight);
+	linkComboBox.setBounds((int)(getWidth() - 0.95f * width), posY, (int)(0.9f * width), buttonHeight);
+
+	// Options, a label column and the menu over the next columns, one row per BOTTOM_MENU_HEIGHT
+	const int optionRowHeight = (int)(BOTTOM_MENU_HEIGHT * 0.01f * SCALE);
+
+	auto placeOption = [&](juce::Component& label, juce::Component& menu, int row, int column, float columns)
+	{
+		const int optionPosY = posY + (row + 1) * optionRowHeight;
+		label.setBounds(column * width, optionPosY, width, buttonHeight);
+		menu.setBounds((int)((column + 1.05f) * width), optionPosY, (int)((columns - 0.1f) * width), buttonHeight);
+	};
+
+	// Row 1, under Timing
+	placeOption(oversamplingLabel, oversamplingComboBox, 0, 0, 1.0f);
+	placeOption(detectorLabel, detectorComboBox, 0, 2, 1.0f);
+	placeOption(rmsWindowLabel, rmsWindowSlider, 0, 4, 2.0f);
+
+	// Row 2, the crossovers fill the columns after their label
+	placeOption(bandsLabel, bandsComboBox, 1, 0, 1.0f);
+	crossoverLabel.setBounds(2 * width, posY + 2 * optionRowHeight, width, buttonHeight);
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+		crossoverSliders[split].setBounds((int)((split + 3.05f) * width), posY + 2 * optionRowHeight, (int)(0.9f * width), buttonHeight);
+
+	// Row 3, the sidechain switch is a toggle in the menu column
+	placeOption(sidechainLabel, sidechainButton, 2, 0, 1.0f);
+	placeOption(keyFilterLabel, keyFilterComboBox, 2, 2, 1.0f);
+	placeOption(keyFrequencyLabel, keyFrequencySlider, 2, 4, 2.0f);
+
+	// Meters
 	const int menuWidth = (int)(width * 0.9f);
-	juce::Rectangle<int> debugMenuRectangle;
-	const int debugMenuPosY = (int)(height + BOTTOM_MENU_HEIGHT * 1.3f);
-	debugMenuRectangle.setSize(menuWidth, (int)(BOTTOM_MENU_HEIGHT * 0.4f));
+	juce::Rectangle<int> meterRectangle;
+	const int meterPosY = (int)(height + BOTTOM_MENU_HEIGHT * 1.3f) + OPTION_ROWS * optionRowHeight;
+	meterRectangle.setSize(menuWidth, (int)(BOTTOM_MENU_HEIGHT * 0.4f));
 
 	//1
-	debugMenuRectangle.setPosition((int)(0.05f * width), debugMenuPosY);
-	attackTimeLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(0.05f * width), meterPosY);
+	attackTimeLabel.setBounds(meterRectangle);
 
 	//2
-	debugMenuRectangle.setPosition((int)(1.05f * width), debugMenuPosY);
-	releaseTimeLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(1.05f * width), meterPosY);
+	releaseTimeLabel.setBounds(meterRectangle);
 
 	//3
-	debugMenuRectangle.setPosition((int)(2.05f * width), debugMenuPosY);
-	crestFactorLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(2.05f * width), meterPosY);
+	crestFactorLabel.setBounds(meterRectangle);
 
 	//4
-	debugMenuRectangle.setPosition((int)(3.05f * width), debugMenuPosY);
-	gainReductionLabel.setBounds(debugMenuRectangle);
+	meterRectangle.setPosition((int)(3.05f * width), meterPosY);
+	gainReductionLabel.setBounds(meterRectangle);
 
 	//5
-	debugMenuRectangle.setPosition((int)(4.05f * width), debugMenuPosY);
+	meterRectangle.setPosition((int)(4.05f * width), meterPosY);
+	inputLevelLabel.setBounds(meterRectangle);
 
 	//6
-#endif
+	meterRectangle.setPosition((int)(5.05f * width), meterPosY);
+	outputLevelLabel.setBounds(meterRectangle);
+
+	// History over the first six columns, the square transfer curve in the last
+	const int displayPosY = meterPosY + meterRectangle.getHeight() + (int)(LABEL_OFFSET * 0.01f * SCALE);
+	const int displayHeight = juce::jmax(0, getHeight() - displayPosY - (int)(0.05f * width));
+	const int curveSize = juce::jmin(displayHeight, menuWidth);
+
+	m_history.setBounds((int)(0.05f * width), displayPosY, (int)((N_SLIDERS_COUNT - 1) * width - 0.1f * width), displayHeight);
+	m_transferCurve.setBounds((int)(getWidth() - 0.95f * width), displayPosY, curveSize, curveSize);
 }
\ No newline at end of file
@@ -10,20 +10,17 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "GainReductionDisplay.h"
 
 //==============================================================================
-#if DEBUG
 class CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Timer
-#else
-class CompressorAudioProcessorEditor : public juce::AudioProcessorEditor
-#endif
 {
 public:
     CompressorAudioProcessorEditor (CompressorAudioProcessor&, juce::AudioProcessorValueTreeState&);
     ~CompressorAudioProcessorEditor() override;
 
 	// GUI setup
-	static const int N_SLIDERS_COUNT = 6;
+	static const int N_SLIDERS_COUNT = 7;
 	static const int SCALE = 70;
 	static const int LABEL_OFFSET = 25;
 	static const int SLIDER_WIDTH = 200;
@@ -32,10 +29,16 @@ public:
 	static const int TYPE_BUTTON_GROUP = 1;
 	static const int BOTTOM_MENU_HEIGHT = 50;
 
+	// Rows of option menus under the Timing and Link menus, BOTTOM_MENU_HEIGHT each
+	static const int OPTION_ROWS = 3;
+	static const int DISPLAY_HEIGHT = 200;
+
+	// Displays redraw at FRAME_RATE, the meter labels at LABEL_RATE so they stay readable
+	static const int FRAME_RATE = 30;
+	static const int LABEL_RATE = 5;
+
     //==============================================================================
-#ifdef DEBUG
 	void timerCallback() override;
-#endif
 	void paint (juce::Graphics&) override;
     void resized() override;
 
@@ -49,6 +52,12 @@ private:
 
 	juce::AudioProcessorValueTreeState& valueTreeState;
 
+	// Own colours, the default LookAndFeel is shared by every plugin instance. Declared first, outlives the components
+	juce::LookAndFeel_V4 m_lookAndFeel;
+
+	// Everything behind the components, rendered in resized
+	juce::Image m_background;
+
 	juce::Label m_labels[N_SLIDERS_COUNT] = {};
 	juce::Slider m_sliders[N_SLIDERS_COUNT] = {};
 	std::unique_ptr<SliderAttachment> m_sliderAttachment[N_SLIDERS_COUNT] = {};
@@ -67,12 +76,87 @@ private:
 	std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> buttonCAttachment;
 	std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> buttonDAttachment;
 
-#ifdef DEBUG
+	juce::ComboBox automationComboBox;
+	std::unique_ptr<ComboBoxAttachment> automationAttachment;
+
+	juce::Label linkLabel;
+	juce::ComboBox linkComboBox;
+	std::unique_ptr<ComboBoxAttachment> linkAttachment;
+
+	juce::Label oversamplingLabel;
+	juce::ComboBox oversamplingComboBox;
+	std::unique_ptr<ComboBoxAttachment> oversamplingAttachment;
+
+	juce::Label detectorLabel;
+	juce::ComboBox detectorComboBox;
+	std::unique_ptr<ComboBoxAttachment> detectorAttachment;
+
+	juce::Label rmsWindowLabel;
+	juce::Slider rmsWindowSlider;
+	std::unique_ptr<SliderAttachment> rmsWindowAttachment;
+
+	// Bands and the crossovers between them, band modes and thresholds are left to the host
+	static const int MAX_BANDS = CompressorAudioProcessor::MAX_BANDS;
+
+	juce::Label bandsLabel;
+	juce::ComboBox bandsComboBox;
+	std::unique_ptr<ComboBoxAttachment> bandsAttachment;
+
+	juce::Label crossoverLabel;
+	juce::Slider crossoverSliders[MAX_BANDS - 1];
+	std::unique_ptr<SliderAttachment> crossoverAttachments[MAX_BANDS - 1];
+
+	// Auto makeup switch and its gain, in the corners of the Volume knob
+	static const int VOLUME_SLIDER = 5;
+
+	juce::TextButton autoMakeupButton{ "Auto" };
+	std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> autoMakeupAttachment;
+	juce::Label makeupLabel;
+
+	// Sidechain key and its filter
+	juce::Label sidechainLabel;
+	juce::ToggleButton sidechainButton;
+	std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> sidechainAttachment;
+
+	juce::Label keyFilterLabel;
+	juce::ComboBox keyFilterComboBox;
+	std::unique_ptr<ComboBoxAttachment> keyFilterAttachment;
+
+	juce::Label keyFrequencyLabel;
+	juce::Slider keyFrequencySlider;
+	std::unique_ptr<SliderAttachment> keyFrequencyAttachment;
+
+	// Meters
 	juce::Label crestFactorLabel;
 	juce::Label gainReductionLabel;
 	juce::Label attackTimeLabel;
 	juce::Label releaseTimeLabel;
-#endif
+	juce::Label inputLevelLabel;
+	juce::Label outputLevelLabel;
+
+	// Label of an option menu, styled like the Timing and Link labels
+	void addOptionLabel(juce::Label& label, const juce::String& text);
+
+	// Only the crossovers of the selected band count are enabled
+	void updateCrossovers();
+
+	// The RMS window is enabled for RMS and Hybrid
+	void updateRmsWindow();
+
+	// The key frequency is enabled while the key filter is on
+	void updateKeyFrequency();
+
+	// Frames since the last label update
+	MeterFrame m_labelFrame;
+	int m_labelTicks = 0;
+
+	GainReductionHistory m_history;
+	TransferCurve m_transferCurve;
+
+	std::atomic<float>* m_thresholdParameter = nullptr;
+	std::atomic<float>* m_ratioParameter = nullptr;
+	std::atomic<float>* m_mixParameter = nullptr;
+	std::atomic<float>* m_volumeParameter = nullptr;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorAudioProcessorEditor)
 };
@@ -8,76 +8,63 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include <set>
 
-//==============================================================================
-EnvelopeFollower::EnvelopeFollower()
-{
-}
+const std::string CompressorAudioProcessor::paramsNames[] = { "Attack", "Release", "Ratio", "Threshold", "Mix", "Volume", "Lookahead" };
+const juce::StringArray CompressorAudioProcessor::linkNames = { "Off", "Max", "Mean", "Weighted" };
+const juce::StringArray CompressorAudioProcessor::automationNames = { "Manual", "Auto" };
+const juce::StringArray CompressorAudioProcessor::detectorNames = { "Peak", "RMS", "Hybrid" };
+const juce::StringArray CompressorAudioProcessor::keyFilterNames = { "Off", "High Pass", "Band Pass" };
+const juce::StringArray CompressorAudioProcessor::oversamplingNames = { "Off", "2x", "4x", "8x" };
+const juce::StringArray CompressorAudioProcessor::bandsNames = { "1", "2", "3", "4", "5" };
+const juce::StringArray CompressorAudioProcessor::bandModeNames = { "Global", "A", "B", "C", "D" };
 
-void EnvelopeFollower::setCoef(float attackTimeMs, float releaseTimeMs)
-{
-	m_AttackCoef = exp(-1000.0f / (attackTimeMs * m_SampleRate));
-	m_ReleaseCoef = exp(-1000.0f / (releaseTimeMs * m_SampleRate));
-}
-
-float EnvelopeFollower::process(float in)
+//==============================================================================
+// Drains the profile frames of a processor into a Chrome trace, off the audio thread
+class TraceWriterThread : public juce::Thread
 {
-	if (m_ballisticType == ballisticType::Decoupled)
+public:
+	TraceWriterThread(CompressorAudioProcessor& processor, const juce::File& file)
+		: juce::Thread("Compressor trace"), m_processor(processor)
 	{
-		m_Out1Last = fmax(fabs(in), m_ReleaseCoef * m_Out1Last);
-		return m_OutLast = m_AttackCoef * m_OutLast + (1.0f - m_AttackCoef) * m_Out1Last;
+		m_trace.open(file.getFullPathName().toStdString());
 	}
-	else if (m_ballisticType == ballisticType::Branching)
-	{
-		const float inAbs = fabs(in);
-		if (inAbs > m_OutLast)
-		{
-			return m_OutLast = m_AttackCoef * m_OutLast + (1.0f - m_AttackCoef) * inAbs;
-		}
-		else
-		{
-			return m_OutLast = m_ReleaseCoef * m_OutLast;
-		}
-	}
-	else if (m_ballisticType == ballisticType::SmoothDecoupled)
+
+	~TraceWriterThread() override
 	{
-		const float inAbs = fabs(in);
-		m_Out1Last = fmaxf(inAbs, m_ReleaseCoef * m_Out1Last + (1.0f - m_ReleaseCoef) * inAbs);
-		return m_OutLast = m_AttackCoef * m_OutLast + (1.0f - m_AttackCoef) * m_Out1Last;
+		stopThread(1000);
+		m_trace.close();
 	}
-	else if (m_ballisticType == ballisticType::SmoothBranching)
+
+	void run() override
 	{
-		const float inAbs = fabs(in);
-		if (inAbs > m_OutLast)
-		{
-			return m_OutLast = m_AttackCoef * m_OutLast + (1.0f - m_AttackCoef) * inAbs;
-		}
-		else
+		while (! threadShouldExit())
 		{
-			return m_OutLast = m_ReleaseCoef * m_OutLast + (1.0f - m_ReleaseCoef) * inAbs;
+			ProfileFrame frame;
+			while (m_processor.popProfileFrame(frame))
+				m_trace.write(frame);
+
+			wait(50);
 		}
 	}
 
-	return 0.0f;
-}
-
-const std::string CompressorAudioProcessor::paramsNames[] = { "Attack", "Release", "Ratio", "Threshold", "Mix", "Volume" };
+private:
+	CompressorAudioProcessor& m_processor;
+	ChromeTrace m_trace;
+};
 
 //==============================================================================
-CrestFactor::CrestFactor()
+// FNV-1a of a parameter ID, the key of its value in the binary state
+static juce::uint32 getParameterHash(const juce::String& id)
 {
-}
+	juce::uint32 hash = 2166136261u;
 
-float CrestFactor::process(float in)
-{
-	const float inSQ = in * in;
-	const float inFactor = (1.0f - m_Coef) * inSQ;
+	for (const char* character = id.toRawUTF8(); *character != 0; ++character)
+		hash = (hash ^ (juce::uint8)*character) * 16777619u;
 
-	m_PeakLastSQ = std::max(inSQ, m_Coef * m_PeakLastSQ + inFactor);
-	m_RMSLastSQ = m_Coef * m_RMSLastSQ + inFactor;
-
-	return std::sqrtf(m_PeakLastSQ / m_RMSLastSQ);
+	return hash;
 }
+
 //==============================================================================
 CompressorAudioProcessor::CompressorAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -85,6 +72,7 @@ CompressorAudioProcessor::CompressorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -97,15 +85,56 @@ CompressorAudioProcessor::CompressorAudioProcessor()
 	thresholdParameter = apvts.getRawParameterValue(paramsNames[3]);
 	mixParameter       = apvts.getRawParameterValue(paramsNames[4]);
 	volumeParameter    = apvts.getRawParameterValue(paramsNames[5]);
+	autoMakeupParameter = apvts.getRawParameterValue("AutoMakeup");
+	lookaheadParameter = apvts.getRawParameterValue(paramsNames[6]);
+	linkParameter      = apvts.getRawParameterValue("Link");
+	automationParameter = apvts.getRawParameterValue("Automation");
+	detectorParameter = apvts.getRawParameterValue("Detector");
+	rmsWindowParameter = apvts.getRawParameterValue("RMSWindow");
+	sidechainParameter = apvts.getRawParameterValue("Sidechain");
+	keyFilterParameter = apvts.getRawParameterValue("KeyFilter");
+	keyFrequencyParameter = apvts.getRawParameterValue("KeyFrequency");
+	oversamplingParameter = apvts.getRawParameterValue("Oversampling");
+	bandsParameter = apvts.getRawParameterValue("Bands");
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+		crossoverParameters[split] = apvts.getRawParameterValue("Crossover" + juce::String(split + 1));
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+	{
+		bandModeParameters[band] = apvts.getRawParameterValue("Band" + juce::String(band + 1) + "Mode");
+		bandThresholdParameters[band] = apvts.getRawParameterValue("Band" + juce::String(band + 1) + "Threshold");
+	}
+
+	buttonAParameter = apvts.getRawParameterValue("ButtonA");
+	buttonBParameter = apvts.getRawParameterValue("ButtonB");
+	buttonCParameter = apvts.getRawParameterValue("ButtonC");
+	buttonDParameter = apvts.getRawParameterValue("ButtonD");
+
+	for (auto* parameter : AudioProcessor::getParameters())
+	{
+		if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+		{
+			m_parameterList.push_back(ranged);
+			m_parameterHashes.push_back(getParameterHash(ranged->getParameterID()));
+		}
+	}
+
+	// IDs must stay distinguishable in the binary state
+	jassert(std::set<juce::uint32>(m_parameterHashes.begin(), m_parameterHashes.end()).size() == m_parameterHashes.size());
+
+	m_presets.build(m_parameterList, apvts, [this](const PresetBank::ValueSource& value) { return getParameters(value); });
 
-	buttonAParameter = static_cast<juce::AudioParameterBool*>(apvts.getParameter("ButtonA"));
-	buttonBParameter = static_cast<juce::AudioParameterBool*>(apvts.getParameter("ButtonB"));
-	buttonCParameter = static_cast<juce::AudioParameterBool*>(apvts.getParameter("ButtonC"));
-	buttonDParameter = static_cast<juce::AudioParameterBool*>(apvts.getParameter("ButtonD"));
+	// The editor or the renderer log reads the meters
+	m_engine.setMetering(true);
+
+	// Detector, Oversampling and Bands are automatable, none of them may wait for a prepare
+	m_engine.setMaxRmsWindows(true);
 }
 
 CompressorAudioProcessor::~CompressorAudioProcessor()
 {
+	m_traceWriter.reset();
 }
 
 //==============================================================================
@@ -148,39 +177,54 @@ double CompressorAudioProcessor::getTailLengthSeconds() const
 
 int CompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+	return juce::jmax(1, m_presets.size());
 }
 
 int CompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+	return m_presets.getCurrent();
 }
 
 void CompressorAudioProcessor::setCurrentProgram (int index)
 {
+	// Hosts may call this from the audio thread, there select only swaps the snapshot and posts the parameter write
+	m_presets.select(index);
 }
 
 const juce::String CompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+	return (index >= 0 && index < m_presets.size()) ? m_presets[index].name : juce::String();
 }
 
 void CompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+	// Factory presets keep their names
 }
 
 //==============================================================================
+
 void CompressorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-	m_envelopeFollower[0].init((int)(sampleRate));
-	m_envelopeFollower[1].init((int)(sampleRate));
+	const int channels = juce::jmax(1, getTotalNumOutputChannels());
+
+	// The engine starts on the current values, no ramp. The host picks the precision before prepareToPlay
+	m_engine.setParameters(getParameters());
+	m_engine.prepare(sampleRate, samplesPerBlock, channels, isUsingDoublePrecision(), getSidechainChannels());
+
+	updateLinkWeights(getChannelLayoutOfBus(false, 0), channels);
+
+	// Dry and wet both pass the filters and the delay, so the whole output is delayed
+	setLatencySamples(m_engine.getLatencySamples());
 
-	m_crestFactor[0].init((int)(sampleRate));
-	m_crestFactor[1].init((int)(sampleRate));
+	// Standalone app started with COMPRESSOR_TRACE=<file.json>, one trace per run
+	const juce::String tracePath = juce::SystemStats::getEnvironmentVariable("COMPRESSOR_TRACE", {});
 
-	m_crestFactor[0].setCoef(0.2f);
-	m_crestFactor[1].setCoef(0.2f);
+	if (wrapperType == wrapperType_Standalone && tracePath.isNotEmpty() && m_traceWriter == nullptr)
+	{
+		m_engine.setProfiling(true);
+		m_traceWriter = std::make_unique<TraceWriterThread>(*this, juce::File::getCurrentWorkingDirectory().getChildFile(tracePath));
+		m_traceWriter->startThread();
+	}
 }
 
 void CompressorAudioProcessor::releaseResources()
@@ -195,12 +239,8 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any channel count, every channel has its own detector
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -209,215 +249,171 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
         return false;
    #endif
 
+    // Sidechain of any layout or none, one of another layout than the main bus is linked
+
     return true;
   #endif
 }
 #endif
 
+
 void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-	// Get params
-	const auto attack = attackParameter->load();
-	const auto release = releaseParameter->load();
-	const auto ratio = ratioParameter->load();
-	const auto threshold = thresholdParameter->load();
-	const auto mix = mixParameter->load();
-	const auto volume = juce::Decibels::decibelsToGain(volumeParameter->load());
-
-	// Buttons
-	const auto buttonA = buttonAParameter->get();
-	const auto buttonB = buttonBParameter->get();
-	const auto buttonC = buttonCParameter->get();
-	const auto buttonD = buttonDParameter->get();
-
-	CompressorAudioProcessor::architecture architecture = architecture::LogDomain;
-	EnvelopeFollower::ballisticType ballisticType = EnvelopeFollower::ballisticType::SmoothDecoupled;
-
-	if (buttonB)
-	{
-		architecture = architecture::LogDomain;
-		ballisticType = EnvelopeFollower::ballisticType::SmoothBranching;
-	}
-
-	if (buttonC)
-	{
-		architecture = architecture::ReturnToZero;
-		ballisticType = EnvelopeFollower::ballisticType::SmoothDecoupled;
-	}
-
-	if (buttonD)
-	{
-		architecture = architecture::ReturnToZero;
-		ballisticType = EnvelopeFollower::ballisticType::SmoothBranching;
-	}
-
-	// Mics constants
-	const float mixInverse = 1.0f - mix;
-	const float R_Inv_minus_One = (1.0f / ratio) - 1.0f;
-	const int channels = getTotalNumOutputChannels();
-	const int samples = buffer.getNumSamples();		
-
-	for (int channel = 0; channel < channels; ++channel)
-	{
-		// Channel pointer
-		auto* channelBuffer = buffer.getWritePointer(channel);
-		
-		// Envelope reference
-		auto& envelopeFollower = m_envelopeFollower[channel];
-
-		// CrestFactor
-		auto& crestFactor = m_crestFactor[channel];
-		
-		// Set attack and release
-		envelopeFollower.setCoef(attack, release);
-
-		// Set ballistic type
-		envelopeFollower.setBallisticType(ballisticType);
-
-		// ReturToZero
-		if (architecture == architecture::ReturnToZero)
-		{
-			for (int sample = 0; sample < samples; ++sample)
-			{
-				// Get input
-				const float in = channelBuffer[sample];
-
-				//Automation
-				/*if (automation == automation::Auto)
-				{
-					timesAutomation(in, crestFactor, envelopeFollower, attack, release);
-				}*/
-
-				// Smooth
-				const float smooth = envelopeFollower.process(in);
-
-				// Convert input from gain to dB
-				const float smoothdB = juce::Decibels::gainToDecibels(smooth + 0.000001f);
-
-				//Get gain reduction, positive values
-				const float attenuatedB = (smoothdB >= threshold) ? (smoothdB - threshold) * R_Inv_minus_One : 0.0f;
-
-#ifdef DEBUG
-				// Store gain reduction
-				if (fabs(attenuatedB) > m_gainReductiondB)
-					m_gainReductiondB = fabs(attenuatedB);
-#endif
-
-				// Apply gain reduction
-				const float out = in * juce::Decibels::decibelsToGain(attenuatedB);
+	process(buffer, getParameters());
+}
 
-				// Apply volume, mix and send to output
-				channelBuffer[sample] = volume * (mix * out + mixInverse * in);
-			}
-		}
-		else if (architecture == architecture::ReturnToThreshold)
-		{
-			const float thresholdGain = juce::Decibels::decibelsToGain(threshold);
+void CompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+	process(buffer, getParameters());
+}
 
-			for (int sample = 0; sample < samples; ++sample)
-			{
-				// Get input
-				const float in = channelBuffer[sample];
+void CompressorAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, architecture architecture, EnvelopeFollower::ballisticType ballisticType)
+{
+	auto parameters = getParameters();
+	std::fill(std::begin(parameters.modes.architectures), std::end(parameters.modes.architectures), architecture);
+	std::fill(std::begin(parameters.modes.ballisticTypes), std::end(parameters.modes.ballisticTypes), ballisticType);
 
-				// In above threshold
-				const float inOverThrehold = fmaxf(thresholdGain, in);
+	process(buffer, parameters);
+}
 
-				//Automation
-				/*if (automation == automation::Auto)
-				{
-					timesAutomation(in, crestFactor, envelopeFollower, attack, release);
-				}*/
+void CompressorAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, architecture architecture, EnvelopeFollower::ballisticType ballisticType)
+{
+	auto parameters = getParameters();
+	std::fill(std::begin(parameters.modes.architectures), std::end(parameters.modes.architectures), architecture);
+	std::fill(std::begin(parameters.modes.ballisticTypes), std::end(parameters.modes.ballisticTypes), ballisticType);
 
-				// Smooth
-				const float smooth = envelopeFollower.process(inOverThrehold);
+	process(buffer, parameters);
+}
 
-				// Convert input from gain to dB
-				const float smoothdB = juce::Decibels::gainToDecibels(smooth + 0.000001f);
+template<typename Value>
+int CompressorAudioProcessor::getButtonMode(Value value) const
+{
+	// The last pressed button of A-D wins
+	if (value(buttonDParameter) > 0.5f)
+		return 3;
 
-				//Get gain reduction, positive values
-				const float attenuatedB = (smoothdB >= threshold) ? (smoothdB - threshold) * R_Inv_minus_One : 0.0f;
+	if (value(buttonCParameter) > 0.5f)
+		return 2;
 
-#ifdef DEBUG
-				// Store gain reduction
-				if (fabs(attenuatedB) > m_gainReductiondB)
-					m_gainReductiondB = fabs(attenuatedB);
-#endif
+	if (value(buttonBParameter) > 0.5f)
+		return 1;
 
-				// Apply gain reduction
-				const float out = in * juce::Decibels::decibelsToGain(attenuatedB);
+	return 0;
+}
 
-				// Apply volume, mix and send to output
-				channelBuffer[sample] = volume * (mix * out + mixInverse * in);
-			}
-		}
-		else
-		{
-			const float factor = (ratio > 1.0f) ? -1.0f : 1.0f;
+CompressorEngine::Parameters CompressorAudioProcessor::getParameters() const
+{
+	return m_presets.read([this] { return getParameters([](const std::atomic<float>* parameter) { return parameter->load(); }); });
+}
 
-			for (int sample = 0; sample < samples; ++sample)
-			{
-				// Get input
-				const float in = channelBuffer[sample];
+template<typename Value>
+CompressorEngine::Parameters CompressorAudioProcessor::getParameters(Value value) const
+{
+	CompressorEngine::Parameters parameters;
+
+	parameters.attack = value(attackParameter);
+	parameters.release = value(releaseParameter);
+	parameters.ratio = value(ratioParameter);
+	parameters.threshold = value(thresholdParameter);
+	parameters.mix = value(mixParameter);
+	parameters.volume = value(volumeParameter);
+	parameters.autoMakeup = value(autoMakeupParameter) > 0.5f;
+	parameters.lookahead = value(lookaheadParameter);
+	parameters.link = (channelLink)((int)value(linkParameter) + 1);
+	parameters.timing = (automation)((int)value(automationParameter) + 1);
+	parameters.detection = (detector)((int)value(detectorParameter) + 1);
+	parameters.rmsWindow = value(rmsWindowParameter);
+	parameters.sidechain = value(sidechainParameter) > 0.5f;
+	parameters.keyFilter = (keyFilterType)((int)value(keyFilterParameter) + 1);
+	parameters.keyFrequency = value(keyFrequencyParameter);
+	parameters.oversampling = (int)value(oversamplingParameter);
+	parameters.bands = (int)value(bandsParameter) + 1;
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+		parameters.crossovers[split] = value(crossoverParameters[split]);
+
+	// Band modes are Global or A-D, Global follows the buttons
+	const int buttonMode = getButtonMode(value);
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+	{
+		const int mode = (int)value(bandModeParameters[band]);
 
-				// Convert input from gain to dB
-				const float indB = juce::Decibels::gainToDecibels(fabsf(in) + 0.000001f);
+		parameters.bandThresholds[band] = value(bandThresholdParameters[band]);
+		CompressorEngine::getMode((mode > 0) ? mode - 1 : buttonMode, parameters.modes.architectures[band], parameters.modes.ballisticTypes[band]);
+	}
 
-				//Get gain reduction, positive values
-				const float attenuatedB = (indB >= threshold) ? (indB - threshold) * R_Inv_minus_One : 0.0f;
+	return parameters;
+}
 
-				//Automation
-				/*if (automation == automation::Auto)
-				{
-					timesAutomation(in, crestFactor, envelopeFollower, attack, release);
-				}*/
+template<typename SampleType>
+void CompressorAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, const CompressorEngine::Parameters& parameters)
+{
+	m_engine.setParameters(parameters);
 
-				// Smooth
-				const float smoothdB = factor * envelopeFollower.process(attenuatedB);
+	const int channels = juce::jmin(getTotalNumOutputChannels(), buffer.getNumChannels());
 
-#ifdef DEBUG
-				// Store gain reduction
-				if (fabs(smoothdB) > m_gainReductiondB)
-					m_gainReductiondB = fabs(smoothdB);
-#endif
+	// Sidechain channels follow the main ones in the host buffer, the detectors read them in place
+	if (getSidechainChannels() > 0)
+	{
+		const auto sidechain = getBusBuffer(buffer, true, 1);
+		m_engine.process(buffer.getArrayOfWritePointers(), channels, buffer.getNumSamples(), sidechain.getArrayOfReadPointers(), sidechain.getNumChannels());
+	}
+	else
+	{
+		m_engine.process(buffer.getArrayOfWritePointers(), channels, buffer.getNumSamples());
+	}
 
-				// Apply gain reduction
-				const float out = in * juce::Decibels::decibelsToGain(smoothdB);
+	// A new look-ahead length or oversampling factor changes the latency
+	if (m_engine.getLatencySamples() != getLatencySamples())
+		setLatencySamples(m_engine.getLatencySamples());
+}
 
-				// Apply volume, mix and send to output
-				channelBuffer[sample] = volume * (mix * out + mixInverse * in);
-			}
-		}
-	}
+int CompressorAudioProcessor::getSidechainChannels() const
+{
+	return (getBusCount(true) > 1) ? getChannelCountOfBus(true, 1) : 0;
 }
 
 //==============================================================================
-void CompressorAudioProcessor::timesAutomation(float in, CrestFactor& crestFactor, EnvelopeFollower& envelopeFollower, float attack, float release)
+// ITU-R BS.1770 channel weights, surrounds +1.5 dB and LFE ignored, normalized to unity sum.
+// The standard weighs channel power, the link sums levels, so the amplitude weight is its root
+void CompressorAudioProcessor::updateLinkWeights(const juce::AudioChannelSet& channelSet, int channels)
 {
-	const float crest = crestFactor.process(in);
-	const float crestSQ = crest * crest;
-	const float crestMultiplier = 1.0f - std::min(crestSQ / 40.0f, 1.0f);
-
-	float attackAuto = attack * crestMultiplier;
-	if (attackAuto <= 0.1f)
-		attackAuto = 0.1f;
-
-	float releaseAuto = release * crestMultiplier;
-	if (releaseAuto <= 30.0f)
-		releaseAuto = 30.0f;
+	std::vector<float> weights((size_t)channels, 1.0f);
 
-	envelopeFollower.setCoef(attackAuto, releaseAuto);
+	for (int channel = 0; channel < channels && channel < channelSet.size(); ++channel)
+	{
+		switch (channelSet.getTypeOfChannel(channel))
+		{
+		case juce::AudioChannelSet::LFE:
+		case juce::AudioChannelSet::LFE2:
+			weights[channel] = 0.0f;
+			break;
+
+		case juce::AudioChannelSet::leftSurround:
+		case juce::AudioChannelSet::rightSurround:
+		case juce::AudioChannelSet::centreSurround:
+		case juce::AudioChannelSet::leftSurroundSide:
+		case juce::AudioChannelSet::rightSurroundSide:
+		case juce::AudioChannelSet::leftSurroundRear:
+		case juce::AudioChannelSet::rightSurroundRear:
+			weights[channel] = std::sqrt(1.41f);
+			break;
+
+		default:
+			break;
+		}
+	}
 
-#ifdef DEBUG
-	// Values for meters
-	if (attackAuto > m_attackTime)
-		m_attackTime = attackAuto;
+	float sum = 0.0f;
+	for (auto weight : weights)
+		sum += weight;
 
-	if (releaseAuto > m_releaseTime)
-		m_releaseTime = releaseAuto;
+	// Only LFE, fall back to equal weights
+	for (auto& weight : weights)
+		weight = (sum > 0.0f) ? weight / sum : 1.0f / channels;
 
-	if (crestMultiplier * 100.0f > m_crestFactorPercentage)
-		m_crestFactorPercentage = crestMultiplier * 100.0f;
-#endif
+	m_engine.setLinkWeights(weights.data());
 }
 
 //==============================================================================
@@ -433,14 +429,30 @@ juce::AudioProcessorEditor* CompressorAudioProcessor::createEditor()
 
 //==============================================================================
 void CompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{	
-	auto state = apvts.copyState();
-	std::unique_ptr<juce::XmlElement> xml(state.createXml());
-	copyXmlToBinary(*xml, destData);
+{
+	// Magic, version, program, count, then the hash of the ID and the plain value of every parameter
+	juce::MemoryOutputStream stream(destData, false);
+
+	stream.writeInt(STATE_MAGIC);
+	stream.writeInt(STATE_VERSION);
+	stream.writeInt(m_presets.getCurrent());
+	stream.writeInt((int)m_parameterList.size());
+
+	for (size_t parameter = 0; parameter < m_parameterList.size(); ++parameter)
+	{
+		stream.writeInt((int)m_parameterHashes[parameter]);
+		stream.writeFloat(m_parameterList[parameter]->convertFrom0to1(m_parameterList[parameter]->getValue()));
+	}
 }
 
 void CompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+	juce::MemoryInputStream stream(data, (size_t)juce::jmax(0, sizeInBytes), false);
+
+	if (setBinaryState(stream))
+		return;
+
+	// Sessions saved before the binary state
 	std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
 
 	if (xmlState.get() != nullptr)
@@ -448,6 +460,47 @@ void CompressorAudioProcessor::setStateInformation (const void* data, int sizeIn
 			apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
 }
 
+bool CompressorAudioProcessor::setBinaryState(juce::MemoryInputStream& stream)
+{
+	if (stream.getNumBytesRemaining() < 16 || stream.readInt() != STATE_MAGIC)
+		return false;
+
+	const int version = stream.readInt();
+	const int program = stream.readInt();
+	const int count = stream.readInt();
+
+	// A newer plugin's state keeps the current values
+	if (version < 1 || version > STATE_VERSION || count < 0 || stream.getNumBytesRemaining() < (juce::int64)count * 8)
+		return true;
+
+	// Parameters missing from the state take their defaults, unknown ones are skipped
+	std::vector<float> values;
+
+	for (auto* parameter : m_parameterList)
+		values.push_back(parameter->getDefaultValue());
+
+	for (int i = 0; i < count; ++i)
+	{
+		const juce::uint32 hash = (juce::uint32)stream.readInt();
+		const float value = stream.readFloat();
+
+		const auto found = std::find(m_parameterHashes.begin(), m_parameterHashes.end(), hash);
+
+		if (found != m_parameterHashes.end())
+		{
+			const size_t parameter = (size_t)(found - m_parameterHashes.begin());
+			values[parameter] = m_parameterList[parameter]->convertTo0to1(value);
+		}
+	}
+
+	for (size_t parameter = 0; parameter < m_parameterList.size(); ++parameter)
+		m_parameterList[parameter]->setValueNotifyingHost(values[parameter]);
+
+	m_presets.setCurrent(juce::jlimit(0, juce::jmax(0, m_presets.size() - 1), program));
+
+	return true;
+}
+
 juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::createParameterLayout()
 {
 	APVTS::ParameterLayout layout;
@@ -460,12 +513,44 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::cr
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[3], paramsNames[3], NormalisableRange<float>(-60.0f,  12.0f,  1.0f, 1.0f), -12.0f));
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[4], paramsNames[4], NormalisableRange<float>(  0.0f,   1.0f, 0.05f, 1.0f),   1.0f));
 	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[5], paramsNames[5], NormalisableRange<float>(-24.0f,  24.0f,  0.1f, 1.0f),   0.0f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>(paramsNames[6], paramsNames[6], NormalisableRange<float>(  0.0f, CompressorEngine::MAX_LOOKAHEAD_MS, 0.1f, 1.0f),   0.0f));
+
+	// Volume trims on top of it
+	layout.add(std::make_unique<juce::AudioParameterBool>("AutoMakeup", "Auto Makeup", false));
 
 	layout.add(std::make_unique<juce::AudioParameterBool>("ButtonA", "ButtonA", true));
 	layout.add(std::make_unique<juce::AudioParameterBool>("ButtonB", "ButtonB", false));
 	layout.add(std::make_unique<juce::AudioParameterBool>("ButtonC", "ButtonC", false));
 	layout.add(std::make_unique<juce::AudioParameterBool>("ButtonD", "ButtonD", false));
 
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Link", "Link", linkNames, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Automation", "Automation", automationNames, 0));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Detector", "Detector", detectorNames, 0));
+	layout.add(std::make_unique<juce::AudioParameterFloat>("RMSWindow", "RMS Window", NormalisableRange<float>(CompressorEngine::MIN_RMS_WINDOW_MS, CompressorEngine::MAX_RMS_WINDOW_MS, 0.1f, 0.5f), 10.0f));
+
+	layout.add(std::make_unique<juce::AudioParameterBool>("Sidechain", "Sidechain", false));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("KeyFilter", "Key Filter", keyFilterNames, 0));
+	layout.add(std::make_unique<juce::AudioParameterFloat>("KeyFrequency", "Key Frequency", NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), 1000.0f));
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", oversamplingNames, 0));
+
+	layout.add(std::make_unique<juce::AudioParameterChoice>("Bands", "Bands", bandsNames, 0));
+
+	const CompressorEngine::Parameters defaults;
+
+	for (int split = 0; split < MAX_BANDS - 1; ++split)
+	{
+		const juce::String name = "Crossover" + juce::String(split + 1);
+		layout.add(std::make_unique<juce::AudioParameterFloat>(name, name, NormalisableRange<float>(20.0f, 20000.0f, 1.0f, 0.25f), defaults.crossovers[split]));
+	}
+
+	for (int band = 0; band < MAX_BANDS; ++band)
+	{
+		const juce::String mode = "Band" + juce::String(band + 1) + "Mode";
+		const juce::String threshold = "Band" + juce::String(band + 1) + "Threshold";
+		layout.add(std::make_unique<juce::AudioParameterChoice>(mode, mode, bandModeNames, 0));
+		layout.add(std::make_unique<juce::AudioParameterFloat>(threshold, threshold, NormalisableRange<float>(-CompressorEngine::MAX_BAND_THRESHOLD_DB, CompressorEngine::MAX_BAND_THRESHOLD_DB, 0.1f, 1.0f), 0.0f));
+	}
+
 	return layout;
 }
 
@@ -474,4 +559,4 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::cr
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new CompressorAudioProcessor();
-}
+}
\ No newline at end of file
@@ -9,55 +9,11 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "CompressorEngine.h"
+#include "PresetBank.h"
 
 //==============================================================================
-class EnvelopeFollower
-{
-public:
-	EnvelopeFollower();
-
-	enum ballisticType
-	{
-		Decoupled = 1,
-		Branching,
-		SmoothDecoupled,
-		SmoothBranching
-	};
-
-	void init(int sampleRate) { m_SampleRate = sampleRate; }
-	void setCoef(float attackTime, float releaseTime);
-	float process(float in);
-	void setBallisticType(ballisticType ballisticType) { m_ballisticType = ballisticType; }
-
-protected:
-	ballisticType m_ballisticType = ballisticType::SmoothBranching;
-	int  m_SampleRate = 48000;
-	float m_AttackCoef = 0.0f;
-	float m_ReleaseCoef = 0.0f;
-	
-	float m_OutLast = 0.0f;
-	float m_Out1Last = 0.0f;
-};
-
-//==============================================================================
-class CrestFactor
-{
-public:
-	CrestFactor();
-
-	void init(int sampleRate) { m_SampleRate = sampleRate; }
-	void setCoef(float time) { m_Coef = exp(-1.0f / (m_SampleRate * time)); }
-	float process(float in);
-
-protected:
-	int  m_SampleRate = 48000;
-	float m_Coef = 0.0f;
-
-	float m_PeakLastSQ = 0.0f;
-	float m_RMSLastSQ = 0.0f;
-};
-
-//==============================================================================
+// Plugin wrapper of CompressorEngine, parameters come from the APVTS, link weights from the bus layout
 class CompressorAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
@@ -69,20 +25,30 @@ public:
     CompressorAudioProcessor();
     ~CompressorAudioProcessor() override;
 
-	enum architecture
-	{
-		ReturnToZero = 1,
-		ReturnToThreshold,
-		LogDomain,
-	};
-
-	enum automation
-	{
-		Manual = 1,
-		Auto,
-	};
+	using architecture = CompressorEngine::architecture;
+	using automation = CompressorEngine::automation;
+	using channelLink = CompressorEngine::channelLink;
+	using detector = CompressorEngine::detector;
+	using keyFilterType = CompressorEngine::keyFilterType;
 
 	static const std::string paramsNames[];
+	static const juce::StringArray linkNames;
+	static const juce::StringArray automationNames;
+
+	// Choice index + 1 is the engine detector
+	static const juce::StringArray detectorNames;
+
+	// Choice index + 1 is the engine key filter
+	static const juce::StringArray keyFilterNames;
+
+	// Choice index is the number of 2x stages
+	static const juce::StringArray oversamplingNames;
+
+	// Choice index + 1 is the number of bands, band modes are Global (the A-D buttons) or A-D
+	static const juce::StringArray bandsNames;
+	static const juce::StringArray bandModeNames;
+
+	static const int MAX_BANDS = CompressorEngine::MAX_BANDS;
 
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
@@ -93,6 +59,14 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+	// Double runs the same DSP with double state, no conversion of the host buffer
+	bool supportsDoublePrecisionProcessing() const override { return true; }
+
+	// Processes every band with the given architecture and ballistic type instead of the A-D buttons and band modes
+	void processBlock(juce::AudioBuffer<float>& buffer, architecture architecture, EnvelopeFollower::ballisticType ballisticType);
+	void processBlock(juce::AudioBuffer<double>& buffer, architecture architecture, EnvelopeFollower::ballisticType ballisticType);
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -117,34 +91,24 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-	void timesAutomation(float in, CrestFactor& crestFactor, EnvelopeFollower& envelopeFollower, float attack, float release);
-
-#ifdef DEBUG
-	float getCrestFactor()
-	{ 
-		const float tmp = m_crestFactorPercentage;
-		m_crestFactorPercentage = 0.0f;
-		return tmp;
-	}
-	float getGainReduction()
-	{
-		const float tmp = m_gainReductiondB;
-		m_gainReductiondB = 0.0f;
-		return tmp;
-	}
-	float getAttackTime()
-	{
-		const float tmp = m_attackTime;
-		m_attackTime = 0.0f;
-		return tmp;
-	}
-	float getReleaseTime()
-	{
-		const float tmp = m_releaseTime;
-		m_releaseTime = 0.0f;
-		return tmp;
-	}
-#endif
+	// The wrapped DSP, audio thread only
+	CompressorEngine& getEngine() { return m_engine; }
+
+	// Gain reduction in dB of the last processed samples at the oversampled rate, float processing only, audio thread only
+	const SampleBuffer<float>& getGainCurve() const { return m_engine.getGainCurve(); }
+	int getGainCurveSamples() const { return m_engine.getGainCurveSamples(); }
+	int getGainCurveChannels() const { return m_engine.getGainCurveChannels(); }
+
+	// Meter frames of processed blocks, one consumer, editor or logger
+	bool popMeterFrame(MeterFrame& frame) { return m_engine.popMeterFrame(frame); }
+
+	// All pending frames merged into one, false when none are ready
+	bool popMeterFrames(MeterFrame& frame) { return m_engine.popMeterFrames(frame); }
+
+	// Block and stage timing, see Profiler.h. Frames have one consumer, the trace writer when it runs
+	void setProfiling(bool enabled) { m_engine.setProfiling(enabled); }
+	bool popProfileFrame(ProfileFrame& frame) { return m_engine.popProfileFrame(frame); }
+	const ProfileStats& getProfileStats() const { return m_engine.getProfileStats(); }
 
 	using APVTS = juce::AudioProcessorValueTreeState;
 	static APVTS::ParameterLayout createParameterLayout();
@@ -160,21 +124,66 @@ private:
 	std::atomic<float>* thresholdParameter = nullptr;
 	std::atomic<float>* mixParameter = nullptr;
 	std::atomic<float>* volumeParameter = nullptr;
-
-	juce::AudioParameterBool* buttonAParameter = nullptr;
-	juce::AudioParameterBool* buttonBParameter = nullptr;
-	juce::AudioParameterBool* buttonCParameter = nullptr;
-	juce::AudioParameterBool* buttonDParameter = nullptr;
-
-	EnvelopeFollower m_envelopeFollower[2] = {};
-	CrestFactor m_crestFactor[2] = {};
-
-#ifdef DEBUG
-	float m_attackTime = 0.0f;
-	float m_releaseTime = 0.0f;
-	float m_crestFactorPercentage = 0.0f;
-	float m_gainReductiondB = 0.0f;
-#endif
+	std::atomic<float>* autoMakeupParameter = nullptr;
+	std::atomic<float>* lookaheadParameter = nullptr;
+	std::atomic<float>* linkParameter = nullptr;
+	std::atomic<float>* automationParameter = nullptr;
+	std::atomic<float>* detectorParameter = nullptr;
+	std::atomic<float>* rmsWindowParameter = nullptr;
+	std::atomic<float>* sidechainParameter = nullptr;
+	std::atomic<float>* keyFilterParameter = nullptr;
+	std::atomic<float>* keyFrequencyParameter = nullptr;
+	std::atomic<float>* oversamplingParameter = nullptr;
+	std::atomic<float>* bandsParameter = nullptr;
+	std::atomic<float>* crossoverParameters[MAX_BANDS - 1] = {};
+	std::atomic<float>* bandModeParameters[MAX_BANDS] = {};
+	std::atomic<float>* bandThresholdParameters[MAX_BANDS] = {};
+
+	std::atomic<float>* buttonAParameter = nullptr;
+	std::atomic<float>* buttonBParameter = nullptr;
+	std::atomic<float>* buttonCParameter = nullptr;
+	std::atomic<float>* buttonDParameter = nullptr;
+
+	// Every parameter of the APVTS in host order, with the hash of its ID for the binary state
+	std::vector<juce::RangedAudioParameter*> m_parameterList;
+	std::vector<juce::uint32> m_parameterHashes;
+
+	// Factory presets as programs
+	PresetBank m_presets;
+
+	// Binary state, "CmpS" and its version
+	static const int STATE_MAGIC = 0x53706d43;
+	static const int STATE_VERSION = 1;
+
+	// False when the data is not a binary state of a known version
+	bool setBinaryState(juce::MemoryInputStream& stream);
+
+	CompressorEngine m_engine;
+
+	// Standalone only, writes the profile frames to the Chrome trace named by COMPRESSOR_TRACE
+	std::unique_ptr<juce::Thread> m_traceWriter;
+
+	// Engine parameters from the APVTS, band modes from the buttons and the band mode choices.
+	// The preset snapshot while a program change is being written
+	CompressorEngine::Parameters getParameters() const;
+
+	// Same from value(raw parameter), the plain value of each parameter
+	template<typename Value>
+	CompressorEngine::Parameters getParameters(Value value) const;
+
+	// Mode 0-3 of the A-D buttons
+	template<typename Value>
+	int getButtonMode(Value value) const;
+
+	// Shared body of the float and double processBlock
+	template<typename SampleType>
+	void process(juce::AudioBuffer<SampleType>& buffer, const CompressorEngine::Parameters& parameters);
+
+	// Channels of the enabled sidechain bus, 0 without one
+	int getSidechainChannels() const;
+
+	// ITU-R BS.1770 weights of the Weighted link for the bus layout
+	void updateLinkWeights(const juce::AudioChannelSet& channelSet, int channels);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorAudioProcessor)
 };
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    Factory presets of the plugin as prebuilt parameter snapshots.
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+	struct PresetValue
+	{
+		const char* id;
+		float value;                // Plain, choice index, 0 or 1 for buttons
+	};
+
+	struct FactoryPreset
+	{
+		const char* name;
+		PresetValue values[12];     // Up to the first null id
+	};
+
+	// Modes by buttons, the last pressed one wins, so every preset sets all four. Bands is a choice index too, 2 is 3 bands
+	const FactoryPreset factoryPresets[] =
+	{
+		{ "Default", {} },
+		{ "Vocal", { { "Attack", 5.0f }, { "Release", 80.0f }, { "Ratio", 3.0f }, { "Threshold", -18.0f }, { "Automation", 1.0f } } },
+		{ "Drum Bus", { { "Attack", 20.0f }, { "Release", 60.0f }, { "Ratio", 4.0f }, { "Threshold", -15.0f }, { "Mix", 0.6f }, { "Link", 1.0f },
+		                { "ButtonA", 0.0f }, { "ButtonB", 1.0f }, { "ButtonC", 0.0f }, { "ButtonD", 0.0f } } },
+		{ "Bass", { { "Attack", 15.0f }, { "Release", 120.0f }, { "Ratio", 4.0f }, { "Threshold", -20.0f }, { "Link", 2.0f },
+		            { "ButtonA", 0.0f }, { "ButtonB", 0.0f }, { "ButtonC", 1.0f }, { "ButtonD", 0.0f } } },
+		{ "Master Glue", { { "Attack", 30.0f }, { "Release", 150.0f }, { "Ratio", 2.0f }, { "Threshold", -8.0f }, { "Link", 2.0f }, { "Lookahead", 2.0f }, { "Oversampling", 1.0f } } },
+		{ "Limiter", { { "Attack", 0.1f }, { "Release", 50.0f }, { "Ratio", 8.0f }, { "Threshold", -3.0f }, { "Lookahead", 5.0f }, { "Link", 1.0f }, { "Oversampling", 2.0f },
+		               { "ButtonA", 0.0f }, { "ButtonB", 0.0f }, { "ButtonC", 0.0f }, { "ButtonD", 1.0f } } },
+		{ "Multiband Master", { { "Attack", 20.0f }, { "Release", 120.0f }, { "Ratio", 2.5f }, { "Threshold", -14.0f }, { "Link", 2.0f }, { "Bands", 2.0f },
+		                        { "Band1Threshold", -3.0f }, { "Band2Threshold", 0.0f }, { "Band3Threshold", 2.0f } } },
+	};
+}
+
+//==============================================================================
+void PresetBank::build(const std::vector<juce::RangedAudioParameter*>& parameters, juce::AudioProcessorValueTreeState& apvts, const EngineParameters& toEngine)
+{
+	m_parameters = parameters;
+	m_presets.clear();
+
+	for (const auto& factoryPreset : factoryPresets)
+	{
+		Preset preset;
+		preset.name = factoryPreset.name;
+
+		// Raw value of every parameter with its plain preset value
+		std::vector<std::pair<const std::atomic<float>*, float>> plainValues;
+
+		for (auto* parameter : m_parameters)
+		{
+			float value = parameter->convertFrom0to1(parameter->getDefaultValue());
+
+			for (const auto& presetValue : factoryPreset.values)
+				if (presetValue.id != nullptr && parameter->getParameterID() == presetValue.id)
+					value = presetValue.value;
+
+			preset.values.push_back(parameter->convertTo0to1(value));
+			plainValues.push_back({ apvts.getRawParameterValue(parameter->getParameterID()), value });
+		}
+
+		preset.parameters = toEngine([&plainValues](const std::atomic<float>* raw)
+		{
+			for (const auto& plainValue : plainValues)
+				if (plainValue.first == raw)
+					return plainValue.second;
+
+			jassertfalse;
+			return 0.0f;
+		});
+
+		m_presets.push_back(std::move(preset));
+	}
+
+	m_selected.store(&m_presets[0], std::memory_order_release);
+}
+
+void PresetBank::select(int index)
+{
+	if (index < 0 || index >= size())
+		return;
+
+	m_current.store(index, std::memory_order_relaxed);
+	m_selected.store(&m_presets[(size_t)index], std::memory_order_release);
+
+	// Blocks read the snapshot until the message thread wrote every value
+	open();
+	triggerAsyncUpdate();
+
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		handleUpdateNowIfNeeded();
+}
+
+void PresetBank::open()
+{
+	unsigned sequence = m_sequence.load(std::memory_order_relaxed);
+
+	while ((sequence & 1u) == 0 && ! m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acq_rel))
+	{
+	}
+}
+
+void PresetBank::handleAsyncUpdate()
+{
+	for (;;)
+	{
+		open();
+
+		const Preset* preset = m_selected.load(std::memory_order_acquire);
+
+		for (size_t parameter = 0; parameter < m_parameters.size(); ++parameter)
+			m_parameters[parameter]->setValueNotifyingHost(preset->values[parameter]);
+
+		// Even again unless another preset was selected while writing. One selected after this check
+		// finds the sequence still odd and posts another write, until then blocks keep the whole old preset
+		unsigned sequence = m_sequence.load(std::memory_order_relaxed);
+
+		if (m_selected.load(std::memory_order_acquire) == preset && m_sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acq_rel))
+			return;
+	}
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    Factory presets of the plugin as prebuilt parameter snapshots.
+
+    build() turns every preset into the normalised values of all processor
+    parameters and the engine Parameters those values produce, once, when
+    the processor is created. select() publishes the snapshot of a preset
+    through a sequence lock and leaves writing it to the parameters to the
+    message thread, as notifying the host takes listener locks. Until the
+    write is done a block reading the parameters gets the prebuilt
+    snapshot, so the engine sees the whole preset or none of it.
+
+    On the audio thread select() only swaps the snapshot and posts the
+    write, nothing allocates. Posting takes the short lock of the JUCE
+    message queue on some platforms.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include "CompressorEngine.h"
+
+//==============================================================================
+class PresetBank : private juce::AsyncUpdater
+{
+public:
+	struct Preset
+	{
+		juce::String name;
+		std::vector<float> values;                  // Normalised, one per parameter given to build
+		CompressorEngine::Parameters parameters;    // What the engine gets from these values
+	};
+
+	// Plain value of a raw APVTS parameter
+	using ValueSource = std::function<float(const std::atomic<float>*)>;
+
+	// Engine parameters from a value source, the processor's own mapping
+	using EngineParameters = std::function<CompressorEngine::Parameters(const ValueSource&)>;
+
+	// Prebuilds the factory presets over parameters, those a preset leaves out take their defaults
+	void build(const std::vector<juce::RangedAudioParameter*>& parameters, juce::AudioProcessorValueTreeState& apvts, const EngineParameters& toEngine);
+
+	int size() const { return (int)m_presets.size(); }
+	const Preset& operator[](int index) const { return m_presets[(size_t)index]; }
+
+	int getCurrent() const { return m_current.load(std::memory_order_relaxed); }
+
+	// Only marks the preset as current, e.g. when a session is restored
+	void setCurrent(int index) { m_current.store(index, std::memory_order_relaxed); }
+
+	// The engine gets the preset from the next block, the parameters follow on the message thread, right away
+	// when called from it. Any thread
+	void select(int index);
+
+	// Parameters of the current block, readLive() unless a preset is written meanwhile
+	template<typename ReadLive>
+	CompressorEngine::Parameters read(ReadLive readLive) const
+	{
+		const unsigned before = m_sequence.load(std::memory_order_acquire);
+		CompressorEngine::Parameters parameters = readLive();
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const unsigned after = m_sequence.load(std::memory_order_relaxed);
+
+		// Odd until the selected preset is written, changed when it was written during the read
+		if ((before & 1u) != 0 || before != after)
+			return m_selected.load(std::memory_order_acquire)->parameters;
+
+		return parameters;
+	}
+
+private:
+	// Writes the selected preset to the parameters, again when another one was selected meanwhile
+	void handleAsyncUpdate() override;
+
+	// Makes the sequence odd unless it already is, from any thread
+	void open();
+
+	std::vector<Preset> m_presets;
+	std::vector<juce::RangedAudioParameter*> m_parameters;
+
+	std::atomic<int> m_current{ 0 };
+	std::atomic<const Preset*> m_selected{ nullptr };
+	std::atomic<unsigned> m_sequence{ 0 };
+};
@@ -0,0 +1,277 @@
+/*
+  ==============================================================================
+
+    Real-time timing of the engine, per block and per stage.
+
+    Timestamps are the CPU cycle counter (TSC on x86, the virtual counter on
+    ARM64, steady_clock elsewhere), a read costs a few nanoseconds. The audio
+    thread fills one ProfileFrame per processed block and hands it over
+    through a MeterQueue, block count, deadline overruns and the load
+    histogram are relaxed atomics anyone can read at any time.
+
+    Load is processing time over the duration of the block's audio, above 1
+    the block missed its deadline. ChromeTrace writes frames as a Chrome /
+    Perfetto JSON trace, stages are laid out one after the other inside
+    their block since sub-blocks and bands interleave them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+ #include <intrin.h>
+ #define PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+ #include <x86intrin.h>
+ #define PROFILER_TSC 1
+#endif
+
+namespace Profiler
+{
+	inline uint64_t now()
+	{
+#if PROFILER_TSC
+		return __rdtsc();
+#elif defined(__aarch64__)
+		uint64_t ticks;
+		asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+		return ticks;
+#else
+		return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	// Measured once against steady_clock, about 10 ms on first use, so first call it off the audio thread
+	inline double getTicksPerSecond()
+	{
+		static const double ticksPerSecond = []
+		{
+#if ! PROFILER_TSC && ! defined(__aarch64__)
+			return (double)std::chrono::steady_clock::period::den / (double)std::chrono::steady_clock::period::num;
+#else
+			const auto clockStart = std::chrono::steady_clock::now();
+			const uint64_t ticksStart = now();
+
+			while (std::chrono::steady_clock::now() - clockStart < std::chrono::milliseconds(10))
+			{
+			}
+
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - clockStart).count();
+			return (double)(now() - ticksStart) / seconds;
+#endif
+		}();
+
+		return ticksPerSecond;
+	}
+
+	inline double ticksToSeconds(uint64_t ticks) { return (double)ticks / getTicksPerSecond(); }
+}
+
+//==============================================================================
+// One processed block
+struct ProfileFrame
+{
+	enum Stage
+	{
+		Setup,          // Parameters, ramps and coefficients
+		Oversampling,   // Up and down
+		Crossover,      // Split and sum of the bands
+		Detector,       // Link, auto timing, look-ahead, gain computer and envelope
+		GainStage,      // Gain, mix and volume applied to the audio
+		Meters,         // Peaks of the meter frame
+		STAGES
+	};
+
+	static const char* getStageName(int stage)
+	{
+		static const char* names[STAGES] = { "Setup", "Oversampling", "Crossover", "Detector", "GainStage", "Meters" };
+		return names[stage];
+	}
+
+	uint64_t start = 0;
+	uint64_t ticks = 0;
+	std::array<uint64_t, STAGES> stageTicks = {};
+
+	int samples = 0;
+	int channels = 0;
+	float load = 0.0f;
+};
+
+//==============================================================================
+// Counters of every profiled block, written by the audio thread only
+class ProfileStats
+{
+public:
+	// Load from 0 to 2 in 5 % bins, the last one holds everything above
+	static constexpr int BINS = 41;
+	static constexpr float BIN_WIDTH = 0.05f;
+
+	void add(float load)
+	{
+		const int bin = std::min(BINS - 1, (int)(load / BIN_WIDTH));
+
+		m_histogram[(size_t)bin].fetch_add(1, std::memory_order_relaxed);
+		m_blocks.fetch_add(1, std::memory_order_relaxed);
+
+		if (load > 1.0f)
+			m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+		// Single writer, no compare exchange needed
+		if (load > m_maxLoad.load(std::memory_order_relaxed))
+			m_maxLoad.store(load, std::memory_order_relaxed);
+	}
+
+	// Not concurrent with add, between sessions
+	void reset()
+	{
+		for (auto& bin : m_histogram)
+			bin.store(0, std::memory_order_relaxed);
+
+		m_blocks.store(0, std::memory_order_relaxed);
+		m_overruns.store(0, std::memory_order_relaxed);
+		m_maxLoad.store(0.0f, std::memory_order_relaxed);
+	}
+
+	uint64_t getBlocks() const { return m_blocks.load(std::memory_order_relaxed); }
+	uint64_t getOverruns() const { return m_overruns.load(std::memory_order_relaxed); }
+	uint64_t getHistogram(int bin) const { return m_histogram[(size_t)bin].load(std::memory_order_relaxed); }
+	float getMaxLoad() const { return m_maxLoad.load(std::memory_order_relaxed); }
+
+private:
+	std::array<std::atomic<uint64_t>, BINS> m_histogram = {};
+	std::atomic<uint64_t> m_blocks{ 0 };
+	std::atomic<uint64_t> m_overruns{ 0 };
+	std::atomic<float> m_maxLoad{ 0.0f };
+};
+
+//==============================================================================
+// Accumulates the time since the previous lap into a stage, nothing when disabled
+struct StageTimer
+{
+	StageTimer(ProfileFrame& frame, bool enabled)
+		: m_frame(frame), m_enabled(enabled)
+	{
+		if (enabled)
+			m_frame.start = m_last = Profiler::now();
+	}
+
+	inline void lap(ProfileFrame::Stage stage)
+	{
+		if (! m_enabled)
+			return;
+
+		const uint64_t now = Profiler::now();
+		m_frame.stageTicks[(size_t)stage] += now - m_last;
+		m_last = now;
+	}
+
+	// Total time and load of a block of samples at sampleRate
+	void finish(int samples, double sampleRate)
+	{
+		if (! m_enabled)
+			return;
+
+		m_frame.ticks = Profiler::now() - m_frame.start;
+		m_frame.samples = samples;
+		m_frame.load = (samples > 0) ? (float)(Profiler::ticksToSeconds(m_frame.ticks) * sampleRate / samples) : 0.0f;
+	}
+
+private:
+	ProfileFrame& m_frame;
+	const bool m_enabled;
+	uint64_t m_last = 0;
+};
+
+//==============================================================================
+// Chrome / Perfetto JSON trace, open it in chrome://tracing or ui.perfetto.dev. Not real-time safe
+class ChromeTrace
+{
+public:
+	~ChromeTrace() { close(); }
+
+	bool open(const std::string& path)
+	{
+		close();
+
+		m_file = std::fopen(path.c_str(), "w");
+		m_first = true;
+		m_origin = 0;
+
+		if (m_file != nullptr)
+			std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", m_file);
+
+		return m_file != nullptr;
+	}
+
+	bool isOpen() const { return m_file != nullptr; }
+
+	// One block on track, with its stages and a load counter
+	void write(const ProfileFrame& frame, int track = 1, const char* name = "process")
+	{
+		if (m_file == nullptr)
+			return;
+
+		if (m_origin == 0)
+			m_origin = frame.start;
+
+		// Frames of other threads may start before the first one
+		const double start = (double)(int64_t)(frame.start - m_origin) / Profiler::getTicksPerSecond() * 1.0e6;
+
+		event(name, start, toMicroseconds(frame.ticks), track, frame);
+
+		double stageStart = start;
+		for (int stage = 0; stage < ProfileFrame::STAGES; ++stage)
+		{
+			const double duration = toMicroseconds(frame.stageTicks[(size_t)stage]);
+
+			if (duration > 0.0)
+				event(ProfileFrame::getStageName(stage), stageStart, duration, track, frame);
+
+			stageStart += duration;
+		}
+
+		separator();
+		std::fprintf(m_file, "{\"name\":\"load\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"load\":%.4f}}", start, track, frame.load);
+	}
+
+	void close()
+	{
+		if (m_file == nullptr)
+			return;
+
+		std::fputs("\n]}\n", m_file);
+		std::fclose(m_file);
+		m_file = nullptr;
+	}
+
+private:
+	static double toMicroseconds(uint64_t ticks) { return Profiler::ticksToSeconds(ticks) * 1.0e6; }
+
+	void separator()
+	{
+		if (! m_first)
+			std::fputs(",\n", m_file);
+
+		m_first = false;
+	}
+
+	void event(const char* name, double start, double duration, int track, const ProfileFrame& frame)
+	{
+		separator();
+		std::fprintf(m_file, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"samples\":%d,\"channels\":%d}}",
+			name, start, duration, track, frame.samples, frame.channels);
+	}
+
+	std::FILE* m_file = nullptr;
+	bool m_first = true;
+	uint64_t m_origin = 0;
+};
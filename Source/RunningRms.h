@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Windowed RMS level of the detector input.
+
+    The squares of the last window samples sit in a preallocated ring, a
+    running sum adds the newest and drops the oldest, so every sample costs
+    the same whatever the window length. The subtraction would let rounding
+    errors pile up over hours of audio, a Kahan compensation term carries
+    them into the next step instead. RunningRmsLanes runs 4 channels as the
+    lanes of one vector. Allocated in init, processing does not allocate.
+
+    Hybrid output is the mean of the peak and the RMS level, transients
+    still reach the detector while sustained material is read as RMS.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "FastMath.h"
+
+//==============================================================================
+// SampleType float or double
+template<typename SampleType>
+class RunningRms
+{
+public:
+	void init(int maxWindow)
+	{
+		m_squares.assign((size_t)std::max(1, maxWindow), SampleType(0));
+		setWindow(1);
+	}
+
+	// Clears the window, changed only between blocks
+	void setWindow(int window)
+	{
+		m_window = std::clamp(window, 1, (int)m_squares.size());
+		m_windowInverse = SampleType(1) / SampleType(m_window);
+		reset();
+	}
+
+	void reset()
+	{
+		// Only the window is read, clearing the whole ring would stall a block on long windows
+		std::fill(m_squares.begin(), m_squares.begin() + m_window, SampleType(0));
+		m_sum = SampleType(0);
+		m_compensation = SampleType(0);
+		m_position = 0;
+	}
+
+	// RMS of the last window samples, or its mean with the peak. In and out may be the same buffer
+	void process(const SampleType* in, SampleType* out, int samples, bool hybrid)
+	{
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			const SampleType value = std::abs(in[sample]);
+			const SampleType square = value * value;
+
+			// Newest square in, oldest out, the rounding error of the sum goes into the next step
+			const SampleType delta = (square - m_squares[(size_t)m_position]) - m_compensation;
+			const SampleType sum = m_sum + delta;
+			m_compensation = (sum - m_sum) - delta;
+			m_sum = sum;
+
+			m_squares[(size_t)m_position] = square;
+
+			if (++m_position == m_window)
+				m_position = 0;
+
+			const SampleType rms = std::sqrt(std::max(m_sum, SampleType(0)) * m_windowInverse);
+			out[sample] = hybrid ? SampleType(0.5f) * (value + rms) : rms;
+		}
+	}
+
+private:
+	std::vector<SampleType> m_squares;
+	int m_window = 0;
+	int m_position = 0;
+	SampleType m_windowInverse = SampleType(1);
+
+	SampleType m_sum = SampleType(0);
+	SampleType m_compensation = SampleType(0);
+};
+
+#if FASTMATH_SSE2 || FASTMATH_NEON
+//==============================================================================
+// Same for 4 float channels, one per lane
+class RunningRmsLanes
+{
+public:
+	static constexpr int LANES = 4;
+
+	void init(int maxWindow)
+	{
+		m_squares.assign((size_t)std::max(1, maxWindow), FastMath::Vec4(0.0f));
+		setWindow(1);
+	}
+
+	void setWindow(int window)
+	{
+		m_window = std::clamp(window, 1, (int)m_squares.size());
+		m_windowInverse = 1.0f / (float)m_window;
+		reset();
+	}
+
+	void reset()
+	{
+		std::fill(m_squares.begin(), m_squares.begin() + m_window, FastMath::Vec4(0.0f));
+		m_sum = 0.0f;
+		m_compensation = 0.0f;
+		m_position = 0;
+	}
+
+	// Lane i reads in[i] and writes out[i], which may be the same buffer
+	void process(const float* const* in, float* const* out, int samples, bool hybrid)
+	{
+		using FastMath::Vec4;
+
+		const Vec4 windowInverse = m_windowInverse;
+
+		// Local copies keep the sums in registers, the buffers could alias them otherwise
+		Vec4 sum = m_sum;
+		Vec4 compensation = m_compensation;
+
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			const Vec4 value = abs(Vec4::gather(in, sample));
+			const Vec4 square = value * value;
+
+			Vec4& oldest = m_squares[(size_t)m_position];
+			const Vec4 delta = (square - oldest) - compensation;
+			const Vec4 next = sum + delta;
+			compensation = (next - sum) - delta;
+			sum = next;
+
+			oldest = square;
+
+			if (++m_position == m_window)
+				m_position = 0;
+
+			const Vec4 rms = sqrt(max(sum, Vec4(0.0f)) * windowInverse);
+			(hybrid ? Vec4(0.5f) * (value + rms) : rms).scatter(out, sample);
+		}
+
+		m_sum = sum;
+		m_compensation = compensation;
+	}
+
+private:
+	std::vector<FastMath::Vec4> m_squares;
+	int m_window = 0;
+	int m_position = 0;
+	float m_windowInverse = 1.0f;
+
+	FastMath::Vec4 m_sum{ 0.0f };
+	FastMath::Vec4 m_compensation{ 0.0f };
+};
+#endif
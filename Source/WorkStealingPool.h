@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    Fixed thread pool running one index range per call, with stealing.
+
+    run(count, task) splits [0, count) in one contiguous range per thread,
+    the calling thread takes the first. A thread that finishes its range
+    takes indices from the others, so uneven tasks (idle streams next to
+    oversampled multiband ones) still keep every core busy. Ranges are
+    atomic cursors on their own cache lines, taking an index is one
+    fetch_add, no locks or allocation while a range runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+//==============================================================================
+class WorkStealingPool
+{
+public:
+	// threads counts the calling thread, 1 runs everything on the caller. 0 uses the hardware threads
+	explicit WorkStealingPool(int threads = 0)
+	{
+		if (threads <= 0)
+			threads = (int)std::max(1u, std::thread::hardware_concurrency());
+
+		m_ranges.reset(new Range[(size_t)threads]);
+		m_numThreads = threads;
+
+		for (int thread = 1; thread < threads; ++thread)
+			m_threads.emplace_back([this, thread] { workerLoop(thread); });
+	}
+
+	~WorkStealingPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+
+		m_start.notify_all();
+
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	int getNumThreads() const { return m_numThreads; }
+
+	// Calls task(index) once for every index in [0, count), returns when all are done.
+	// One run at a time, task must not throw
+	template<typename Function>
+	void run(int count, Function& task)
+	{
+		if (count <= 0)
+			return;
+
+		// Few indices, the wake up costs more than it saves
+		const int threads = std::min(m_numThreads, count);
+
+		m_task = &task;
+		m_invoke = [](void* function, int index) { (*static_cast<Function*>(function))(index); };
+
+		for (int thread = 0; thread < m_numThreads; ++thread)
+		{
+			auto& range = m_ranges[(size_t)thread];
+			const int begin = (thread < threads) ? (int)((long long)count * thread / threads) : count;
+			const int end = (thread < threads) ? (int)((long long)count * (thread + 1) / threads) : count;
+
+			range.next.store(begin, std::memory_order_relaxed);
+			range.end = end;
+		}
+
+		m_activeThreads = threads;
+
+		if (threads > 1)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_running = m_numThreads - 1;
+				++m_generation;
+			}
+
+			m_start.notify_all();
+		}
+
+		work(0);
+
+		if (threads > 1)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait(lock, [this] { return m_running == 0; });
+		}
+	}
+
+private:
+	static const int CACHE_LINE_SIZE = 64;
+
+	// Indices [next, end) of one thread, taken from the front by the owner and thieves alike
+	struct alignas(CACHE_LINE_SIZE) Range
+	{
+		std::atomic<int> next{ 0 };
+		int end = 0;
+	};
+
+	// Own range first, then the others in turn
+	void work(int thread)
+	{
+		for (int offset = 0; offset < m_activeThreads; ++offset)
+		{
+			auto& range = m_ranges[(size_t)((thread + offset) % m_activeThreads)];
+
+			for (int index = range.next.fetch_add(1, std::memory_order_relaxed); index < range.end; index = range.next.fetch_add(1, std::memory_order_relaxed))
+				m_invoke(m_task, index);
+		}
+	}
+
+	void workerLoop(int thread)
+	{
+		unsigned generation = 0;
+
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_start.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+
+				if (m_stop)
+					return;
+
+				generation = m_generation;
+			}
+
+			// Threads beyond the active ones only wake to report
+			if (thread < m_activeThreads)
+				work(thread);
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (--m_running == 0)
+					m_done.notify_one();
+			}
+		}
+	}
+
+	int m_numThreads = 1;
+	std::unique_ptr<Range[]> m_ranges;
+	std::vector<std::thread> m_threads;
+
+	// Current run, published to the workers through m_mutex
+	void* m_task = nullptr;
+	void (*m_invoke)(void*, int) = nullptr;
+	int m_activeThreads = 0;
+
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	unsigned m_generation = 0;
+	int m_running = 0;
+	bool m_stop = false;
+};